@@ -0,0 +1,55 @@
+/*
+
+bench: the timing helpers of the benchmarks.
+
+    const double ms = bench::msFor([&] { std::sort(v.begin(), v.end()); });
+    const double ns = bench::nsPerOp(queries.size(), [&] { for (int q : queries) found += contains(q); });
+    bench::keep(found);     // the result is read: the loop is not optimized away
+
+steady_clock around one call of f, no warm up and no repetition: the benchmarks size their own loops.
+
+C++17
+
+*/
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <chrono>
+#include <cstddef>
+
+namespace bench {
+
+// ms for one call of f
+template<typename F>
+double msFor(F&& f)
+{
+    auto start = std::chrono::steady_clock::now();
+    f();
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+// ns per operation, f doing ops of them
+template<typename F>
+double nsPerOp(size_t ops, F&& f)
+{
+    auto start = std::chrono::steady_clock::now();
+    f();
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / ops;
+}
+
+template<typename T>
+inline volatile T g_sink{};
+
+// writes a result to a volatile: the computation of value cannot be optimized away
+template<typename T>
+void keep(T value)
+{
+    g_sink<T> = value;
+}
+
+} // namespace bench
+
+#endif // BENCH_H
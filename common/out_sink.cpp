@@ -0,0 +1,109 @@
+/*
+
+Cost of dumping a big container on stdout, the way the disp/print/display helpers do:
+ - std::endl: std::cout, flushed at every line (one write() per line)
+ - "\n": std::cout, written when the stdio buffer is full
+ - Sink: output::Sink, std::to_chars into blocks of 64KB, 16 blocks per writev()
+ - Async: output::Sink in Mode::Async, "producer" is the time spent by the thread that formats,
+   "total" includes the final flush() waiting for the background writer
+
+The dumps go to stdout, the results to stderr: redirect stdout to a file or /dev/null.
+
+1) g++ -std=c++17 -O2 -Wall -pedantic out_sink.cpp -o out_sink -pthread
+2) ./out_sink 10000000 > /tmp/dump.txt    // from 10K up to 10M elements (default 1M)
+
+*/
+
+#include "out_sink.h"
+#include "bench.h"
+
+#include <iostream>
+#include <iomanip>
+#include <map>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cassert>
+#include <fcntl.h>
+
+// the body of the disp helper of add_maps.cpp, for std::cout and output::Sink
+template<typename Out, typename M, typename EndLine>
+void dumpMap(Out& out, const M& container, EndLine endLine)
+{
+    for (const auto& [key, value] : container) {
+        out << key << " : " << value << endLine;
+    }
+}
+
+template<typename Out, typename V>
+void dumpVector(Out& out, const V& vec)
+{
+    out << "vec: { ";
+    for (const auto& val : vec) {
+        out << val << ", ";
+    }
+    out << "} \n";
+}
+
+void benchmark(size_t size)
+{
+    std::map<std::string, int> players;
+    std::vector<double> values;
+    for (size_t i = 0; i < size; ++i) {
+        players.emplace_hint(players.end(), "player_" + std::to_string(1'000'000'000 + i), static_cast<int>(i));
+        values.push_back(i * 0.25);
+    }
+    auto coutEndl = [](std::ostream& out) -> std::ostream& { return out << std::endl; };
+
+    const double endlMs = bench::msFor([&] { dumpMap(std::cout, players, coutEndl); dumpVector(std::cout, values); std::cout.flush(); });
+    const double newlineMs = bench::msFor([&] { dumpMap(std::cout, players, '\n'); dumpVector(std::cout, values); std::cout.flush(); });
+    const double syncMs = bench::msFor([&] {
+        output::Sink out{STDOUT_FILENO};
+        dumpMap(out, players, '\n');
+        dumpVector(out, values);
+        out.flush();
+    });
+    double producerMs = 0;
+    const double asyncMs = bench::msFor([&] {
+        output::Sink out{STDOUT_FILENO, output::Mode::Async};
+        producerMs = bench::msFor([&] { dumpMap(out, players, '\n'); dumpVector(out, values); });
+        out.flush();
+    });
+
+    std::cerr << std::setw(10) << size << std::setw(11) << endlMs << std::setw(11) << newlineMs
+              << std::setw(11) << syncMs << std::setw(11) << producerMs << std::setw(11) << asyncMs << "\n";
+}
+
+int main(int argc, char* argv[])
+{
+    // 1. same result as std::cout, in order with it
+    std::cout << "std::cout first, ";
+    auto& out = output::stdoutSink();
+    out << "then the sink: " << 42 << ' ' << -7L << ' ' << 2.5 << ' ' << true << ' ' << std::string{"string"} << "\n";
+    out.flush();
+    std::cout << "std::cout again\n";
+
+    // small blocks so that the writer thread gets many of them
+    const char* path = "/tmp/out_sink_check.txt";
+    const int fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    std::string expected;
+    {
+        output::Sink sink{fd, output::Mode::Async, 256};
+        for (int i = 0; i < 100'000; ++i) {
+            sink << i << '\n';
+            expected += std::to_string(i) + '\n';
+        }
+    }
+    ::close(fd);
+    std::ifstream written{path};
+    assert(std::string(std::istreambuf_iterator<char>{written}, {}) == expected);
+    std::cout << std::endl;
+
+    // 2. benchmark: ms to dump a map<string,int> and a vector<double> of size elements each
+    const size_t maxSize = argc > 1 ? std::stoul(argv[1]) : 1'000'000;
+    std::cerr << "                    std::cout         output::Sink     Async\n";
+    std::cerr << "      size  std::endl         \\n       Sync   producer      total  (ms)\n";
+    for (size_t size = 10'000; size <= maxSize; size *= 10) {
+        benchmark(size);
+    }
+}
@@ -0,0 +1,263 @@
+/*
+
+output::Sink: the output of the disp/print/display helpers, formatted into big blocks written with one system call.
+
+std::cout formats through the locale and the stream buffer for every single element, and std::endl flushes
+every line: dumping a big container is then one write() per line. The sink instead:
+ - formats numbers with std::to_chars straight into the current block (no locale, no allocation)
+ - keeps the full blocks and writes them all at once with writev() (16 blocks of 64KB by default)
+ - Mode::Async: a background thread does the writev(), the producer only hands over the full blocks and goes on
+   formatting. The blocks written are given back to the producer, nothing is allocated once running.
+   If the writer is more than 64 blocks behind, the producer waits (bounded memory).
+
+    auto& out = output::stdoutSink();
+    for (const auto& [key, value] : container) out << key << " : " << value << "\n";
+    out.flush();
+
+Types are formatted like std::cout does, except:
+ - bool as true/false (std::boolalpha)
+ - floating point numbers with the shortest representation that reads back the same value (0.1 + 0.2 gives
+   0.30000000000000004 where std::cout gives 0.3)
+ - other types go through their operator<< on a std::ostringstream kept by the sink
+
+flush() returns once everything is written, std::cout is flushed before the sink writes on stdout: the lines of
+both stay in order as long as flush() is called before going back to std::cout. A write error throws
+std::system_error (from flush() in Mode::Async).
+
+C++17, POSIX
+
+*/
+
+#ifndef OUT_SINK_H
+#define OUT_SINK_H
+
+#include <algorithm>
+#include <charconv>
+#include <cerrno>
+#include <climits>
+#include <condition_variable>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace output {
+
+enum class Mode { Sync, Async };
+
+class Sink {
+ public:
+    static constexpr size_t kBatchBlocks = 16;      // Mode::Sync: blocks written by one writev()
+    static constexpr size_t kMaxInFlight = 64;      // Mode::Async: full blocks waiting for the writer
+
+    explicit Sink(int fd = STDOUT_FILENO, Mode mode = Mode::Sync, size_t blockSize = 64 * 1024)
+    :m_fd{fd},m_mode{mode},m_blockSize{std::max<size_t>(blockSize, 256)}
+    {
+        m_current = newBlock();
+        if (m_mode == Mode::Async) m_writer = std::thread{[this] { writerLoop(); }};
+    }
+
+    ~Sink() {
+        try {
+            flush();
+        }
+        catch (const std::system_error&) {
+            // nowhere left to report it
+        }
+        if (m_writer.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock{m_mutex};
+                m_stop = true;
+            }
+            m_wakeWriter.notify_one();
+            m_writer.join();
+        }
+    }
+
+    Sink(const Sink&) = delete;
+    Sink& operator=(const Sink&) = delete;
+
+    template<typename T>
+    Sink& operator<<(const T& value) {
+        if constexpr (std::is_same_v<T, bool>) {
+            append(value ? "true" : "false");
+        }
+        else if constexpr (std::is_same_v<T, char> || std::is_same_v<T, signed char> || std::is_same_v<T, unsigned char>) {
+            if (m_current.size == m_blockSize) nextBlock();
+            m_current.data[m_current.size++] = static_cast<char>(value);
+        }
+        else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+            append(value);
+        }
+        else if constexpr (std::is_arithmetic_v<T>) {
+            constexpr size_t kMaxChars = 32;    // 20 digits and a sign for integers, 24 for a shortest double
+            if (m_blockSize - m_current.size < kMaxChars) nextBlock();
+            char* first = m_current.data.get() + m_current.size;
+            m_current.size += std::to_chars(first, first + kMaxChars, value).ptr - first;
+        }
+        else {
+            m_stream.str({});
+            m_stream << value;
+            append(m_stream.str());
+        }
+        return *this;
+    }
+
+    void append(std::string_view text) {
+        while (!text.empty()) {
+            if (m_current.size == m_blockSize) nextBlock();
+            const size_t count = std::min(text.size(), m_blockSize - m_current.size);
+            std::memcpy(m_current.data.get() + m_current.size, text.data(), count);
+            m_current.size += count;
+            text.remove_prefix(count);
+        }
+    }
+
+    // everything formatted so far is written when it returns
+    void flush() {
+        if (m_current.size > 0) nextBlock();
+        if (m_mode == Mode::Sync) {
+            writeFull();
+            return;
+        }
+        std::unique_lock<std::mutex> lock{m_mutex};
+        m_written.wait(lock, [this] { return m_queue.empty() && !m_writing; });
+        if (m_error) {
+            const auto error = std::exchange(m_error, {});
+            throw std::system_error{error, "output::Sink: writev"};
+        }
+    }
+
+    Mode mode() const { return m_mode; }
+
+ private:
+    struct Block {
+        std::unique_ptr<char[]> data;
+        size_t size = 0;
+    };
+
+    Block newBlock() { return Block{std::make_unique<char[]>(m_blockSize), 0}; }
+
+    // the current block is full (or flushed): hand it over and take an empty one
+    void nextBlock() {
+        if (m_mode == Mode::Sync) {
+            m_full.push_back(std::move(m_current));
+            if (m_full.size() == kBatchBlocks) writeFull();
+            m_current = takeFree(m_free);
+            return;
+        }
+        flushCout();
+        std::unique_lock<std::mutex> lock{m_mutex};
+        m_written.wait(lock, [this] { return m_queue.size() < kMaxInFlight; });
+        m_queue.push_back(std::move(m_current));
+        m_current = takeFree(m_freeShared);
+        lock.unlock();
+        m_wakeWriter.notify_one();
+    }
+
+    Block takeFree(std::vector<Block>& free) {
+        if (free.empty()) return newBlock();
+        Block block = std::move(free.back());
+        free.pop_back();
+        block.size = 0;
+        return block;
+    }
+
+    void flushCout() {
+        if (m_fd == STDOUT_FILENO) std::cout.flush();
+    }
+
+    void writeFull() {
+        if (m_full.empty()) return;
+        flushCout();
+        const auto error = writeBlocks(m_full);
+        for (auto& block : m_full) m_free.push_back(std::move(block));
+        m_full.clear();
+        if (error) throw std::system_error{error, "output::Sink: writev"};
+    }
+
+    // one writev() for all the blocks, more only if the system writes less than asked
+    std::error_code writeBlocks(const std::vector<Block>& blocks) {
+        m_iov.clear();
+        for (const auto& block : blocks) m_iov.push_back({block.data.get(), block.size});
+        size_t first = 0;
+        while (first < m_iov.size()) {
+            const int count = static_cast<int>(std::min<size_t>(m_iov.size() - first, IOV_MAX));
+            ssize_t written = ::writev(m_fd, &m_iov[first], count);
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                return {errno, std::generic_category()};
+            }
+            while (first < m_iov.size() && static_cast<size_t>(written) >= m_iov[first].iov_len) {
+                written -= m_iov[first].iov_len;
+                ++first;
+            }
+            if (written > 0) {
+                m_iov[first].iov_base = static_cast<char*>(m_iov[first].iov_base) + written;
+                m_iov[first].iov_len -= written;
+            }
+        }
+        return {};
+    }
+
+    void writerLoop() {
+        std::vector<Block> blocks;
+        std::unique_lock<std::mutex> lock{m_mutex};
+        while (true) {
+            m_wakeWriter.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+            if (m_queue.empty()) return;    // stopped, everything written
+            blocks.swap(m_queue);
+            m_writing = true;
+            lock.unlock();
+            const auto error = writeBlocks(blocks);
+            lock.lock();
+            if (error && !m_error) m_error = error;
+            for (auto& block : blocks) m_freeShared.push_back(std::move(block));
+            blocks.clear();
+            m_writing = false;
+            m_written.notify_all();
+        }
+    }
+
+    int m_fd;
+    Mode m_mode;
+    size_t m_blockSize;
+    Block m_current;
+    std::ostringstream m_stream;    // only for the types without to_chars
+    std::vector<iovec> m_iov;       // used by the thread that writes
+
+    // Mode::Sync
+    std::vector<Block> m_full;
+    std::vector<Block> m_free;
+
+    // Mode::Async, guarded by m_mutex
+    std::mutex m_mutex;
+    std::condition_variable m_wakeWriter;
+    std::condition_variable m_written;
+    std::vector<Block> m_queue;
+    std::vector<Block> m_freeShared;
+    std::error_code m_error;
+    bool m_writing = false;
+    bool m_stop = false;
+    std::thread m_writer;           // last: started once everything else is constructed
+};
+
+// shared by the helpers of all the examples, written at the latest when the program exits
+inline Sink& stdoutSink()
+{
+    static Sink sink{STDOUT_FILENO};
+    return sink;
+}
+
+} // namespace output
+
+#endif // OUT_SINK_H
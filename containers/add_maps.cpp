@@ -3,17 +3,19 @@
 #include <map>
 #include <string>
 #include <cassert>
+#include "../common/out_sink.h"
 
 template <typename M>
 void disp(const M& container){
-    std::cout << " \n";
-    std::cout << "{ " << "\n";
+    auto& out = output::stdoutSink();
+    out << " \n";
+    out << "{ " << "\n";
     for (const auto& [key,value] : container) {
-        std::cout << key << " : " << value << "\n";
+        out << key << " : " << value << "\n";
     }
-    std::cout << " }\n";
-    std::cout << " \n";
-
+    out << " }\n";
+    out << " \n";
+    out.flush();
 }
 
 int main() {
@@ -0,0 +1,328 @@
+/*
+
+ChunkedVector: a sequence for frequent insertions in the middle.
+
+std::vector::insert away from end() relocates every following element: O(n) per insertion.
+ChunkedVector stores the elements in chunks of at most kChunkBytes (one std::vector each, in order):
+ - insert/erase only move the elements after the position in its chunk, O(chunk size). A full chunk is
+   split in two halves, an empty one is removed: the list of chunks then shifts its vector headers and the
+   index below is rebuilt, O(n / chunk size), but only once every chunk size / 2 insertions
+ - iteration is a contiguous scan of each chunk, one jump per chunk
+ - access by index (operator[], insert(size_t, value)) first finds the chunk in a Fenwick tree of the chunk
+   sizes (prefix sums), O(log(n / chunk size)), updated in O(log(n / chunk size)) by each insert/erase
+
+Same interface as std::vector for what findAndEmplace (iterate.cpp) uses: cbegin/cend, std::find, emplace(const_iterator, ...).
+Like for a vector, an insertion or an erase invalidates the iterators (they hold a chunk number and a pointer in it).
+
+1) g++ -std=c++17 -O2 -Wall -pedantic chunked_vector.cpp -o chunked_vector
+2) ./chunked_vector 10000000    // benchmark from 10K up to 10M elements (default 1M)
+
+*/
+
+#include "../common/bench.h"
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <iterator>
+#include <utility>
+#include <stdexcept>
+#include <random>
+#include <cassert>
+
+
+template<typename T, size_t kChunkBytes = 4096>
+class ChunkedVector {
+ public:
+    using value_type = T;
+    using size_type = size_t;
+    using reference = T&;
+    using const_reference = const T&;
+
+    static constexpr size_t kChunkSize = std::max<size_t>(16, kChunkBytes / sizeof(T));
+
+    template<bool Const>
+    class Iterator {
+     public:
+        using container_type = std::conditional_t<Const, const ChunkedVector, ChunkedVector>;
+        using value_type = T;
+        using reference = std::conditional_t<Const, const T&, T&>;
+        using pointer = std::conditional_t<Const, const T*, T*>;
+        using difference_type = std::ptrdiff_t;
+        using iterator_category = std::bidirectional_iterator_tag;
+
+        Iterator() = default;
+        Iterator(container_type* container, size_t chunk, size_t offset):m_container{container},m_chunk{chunk} {
+            loadChunk();
+            if (m_ptr != nullptr) m_ptr += offset;
+        }
+        operator Iterator<true>() const { return {m_container, m_chunk, offset()}; }
+
+        reference operator*() const { return *m_ptr; }
+        pointer operator->() const { return m_ptr; }
+
+        // the only test per element is the end of the chunk, like a pointer loop
+        Iterator& operator++() {
+            if (++m_ptr == m_chunkEnd) {
+                ++m_chunk;
+                loadChunk();
+            }
+            return *this;
+        }
+        Iterator operator++(int) { auto tmp = *this; ++*this; return tmp; }
+        Iterator& operator--() {
+            if (m_ptr == nullptr || m_ptr == m_container->m_chunks[m_chunk].data()) {
+                --m_chunk;
+                loadChunk();
+                m_ptr = m_chunkEnd;
+            }
+            --m_ptr;
+            return *this;
+        }
+        Iterator operator--(int) { auto tmp = *this; --*this; return tmp; }
+
+        // elements of different chunks never share an address, end() is nullptr
+        bool operator==(const Iterator& other) const { return m_ptr == other.m_ptr; }
+        bool operator!=(const Iterator& other) const { return m_ptr != other.m_ptr; }
+
+     private:
+        friend class ChunkedVector;
+
+        void loadChunk() {
+            if (m_chunk < m_container->m_chunks.size()) {
+                auto& elems = m_container->m_chunks[m_chunk];
+                m_ptr = elems.data();
+                m_chunkEnd = elems.data() + elems.size();
+            }
+            else {
+                m_ptr = m_chunkEnd = nullptr;
+            }
+        }
+        size_t offset() const { return m_ptr != nullptr ? m_ptr - m_container->m_chunks[m_chunk].data() : 0; }
+
+        container_type* m_container = nullptr;
+        size_t m_chunk = 0;     // end() is {number of chunks, nullptr}: chunks are never empty
+        pointer m_ptr = nullptr;
+        pointer m_chunkEnd = nullptr;
+    };
+
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    ChunkedVector() = default;
+    ChunkedVector(std::initializer_list<T> init) { for (const auto& value : init) push_back(value); }
+    template<typename InputIt>
+    ChunkedVector(InputIt first, InputIt last) { for (; first != last; ++first) push_back(*first); }
+
+    iterator begin() { return {this, 0, 0}; }
+    iterator end() { return {this, m_chunks.size(), 0}; }
+    const_iterator begin() const { return {this, 0, 0}; }
+    const_iterator end() const { return {this, m_chunks.size(), 0}; }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    void clear() { m_chunks.clear(); m_index.clear(); m_size = 0; }
+
+    T& operator[](size_t index) { auto pos = locate(index); return m_chunks[pos.first][pos.second]; }
+    const T& operator[](size_t index) const { auto pos = locate(index); return m_chunks[pos.first][pos.second]; }
+    T& at(size_t index) {
+        if (index >= m_size) throw std::out_of_range{"ChunkedVector::at: index out of range"};
+        return (*this)[index];
+    }
+    T& front() { return m_chunks.front().front(); }
+    T& back() { return m_chunks.back().back(); }
+
+    template<typename... Args>
+    T& emplace_back(Args&&... args) { return *emplace(cend(), std::forward<Args>(args)...); }
+    void push_back(const T& value) { emplace_back(value); }
+    void push_back(T&& value) { emplace_back(std::move(value)); }
+    void pop_back() { erase(std::prev(cend())); }
+
+    // O(chunk size): only the elements after pos in its chunk move (plus O(n / chunk size) when a chunk is split)
+    template<typename... Args>
+    iterator emplace(const_iterator pos, Args&&... args);
+
+    iterator insert(const_iterator pos, const T& value) { return emplace(pos, value); }
+    iterator insert(const_iterator pos, T&& value) { return emplace(pos, std::move(value)); }
+    iterator insert(size_t index, const T& value) { return emplace(iteratorAt(index), value); }
+
+    iterator erase(const_iterator pos);
+
+    size_t chunkCount() const { return m_chunks.size(); }
+
+ private:
+    // chunk number and offset of the element at index (index == size() gives end()):
+    // descends the Fenwick tree, skipping the largest blocks of chunks which end before index
+    std::pair<size_t, size_t> locate(size_t index) const {
+        size_t step = 1;
+        while (step * 2 < m_index.size()) step *= 2;
+        size_t chunk = 0;
+        for (; step > 0; step /= 2) {
+            if (chunk + step < m_index.size() && m_index[chunk + step] <= index) {
+                chunk += step;
+                index -= m_index[chunk];
+            }
+        }
+        return {chunk, index};
+    }
+
+    // after a chunk is added or removed, O(number of chunks)
+    void rebuildIndex() {
+        m_index.assign(m_chunks.size() + 1, 0);
+        for (size_t i = 1; i < m_index.size(); ++i) {
+            m_index[i] += m_chunks[i - 1].size();
+            if (const size_t parent = i + (i & -i); parent < m_index.size()) m_index[parent] += m_index[i];
+        }
+    }
+    // one element more or less in chunk, O(log(number of chunks))
+    void addToIndex(size_t chunk, std::ptrdiff_t delta) {
+        for (size_t i = chunk + 1; i < m_index.size(); i += i & -i) m_index[i] += delta;
+    }
+
+    const_iterator iteratorAt(size_t index) const { auto pos = locate(index); return {this, pos.first, pos.second}; }
+
+    std::vector<std::vector<T>> m_chunks;   // moving a chunk only moves its header, never its elements
+    std::vector<size_t> m_index;            // Fenwick tree (1-based) of the chunk sizes: m_index[i] sums the chunks [i - (i & -i), i)
+    size_t m_size = 0;
+};
+
+template<typename T, size_t kChunkBytes>
+template<typename... Args>
+typename ChunkedVector<T, kChunkBytes>::iterator ChunkedVector<T, kChunkBytes>::emplace(const_iterator pos, Args&&... args)
+{
+    size_t chunk = pos.m_chunk;
+    size_t offset = pos.offset();
+    bool newChunk = false;
+    if (chunk == m_chunks.size()) {     // end(): append to the last chunk if it has room
+        if (m_chunks.empty() || m_chunks.back().size() == kChunkSize) {
+            m_chunks.emplace_back().reserve(kChunkSize);
+            newChunk = true;
+        }
+        chunk = m_chunks.size() - 1;
+        offset = m_chunks[chunk].size();
+    }
+    else if (m_chunks[chunk].size() == kChunkSize) {
+        // full: the second half goes to a new chunk right after it
+        std::vector<T> second;
+        second.reserve(kChunkSize);
+        auto middle = m_chunks[chunk].begin() + kChunkSize / 2;
+        second.insert(second.end(), std::make_move_iterator(middle), std::make_move_iterator(m_chunks[chunk].end()));
+        m_chunks[chunk].erase(middle, m_chunks[chunk].end());
+        m_chunks.insert(m_chunks.begin() + chunk + 1, std::move(second));
+        newChunk = true;
+        if (offset > kChunkSize / 2) {
+            ++chunk;
+            offset -= kChunkSize / 2;
+        }
+    }
+    auto& elems = m_chunks[chunk];
+    elems.emplace(elems.begin() + offset, std::forward<Args>(args)...);
+    ++m_size;
+    if (newChunk) rebuildIndex();
+    else addToIndex(chunk, 1);
+    return {this, chunk, offset};
+}
+
+template<typename T, size_t kChunkBytes>
+typename ChunkedVector<T, kChunkBytes>::iterator ChunkedVector<T, kChunkBytes>::erase(const_iterator pos)
+{
+    size_t chunk = pos.m_chunk;
+    size_t offset = pos.offset();
+    auto& elems = m_chunks[chunk];
+    elems.erase(elems.begin() + offset);
+    --m_size;
+    if (elems.empty()) {
+        m_chunks.erase(m_chunks.begin() + chunk);
+        rebuildIndex();
+        return {this, chunk, 0};
+    }
+    addToIndex(chunk, -1);
+    if (offset == elems.size()) return {this, chunk + 1, 0};
+    return {this, chunk, offset};
+}
+
+
+// findAndEmplace of iterate.cpp, unchanged
+template<typename C, typename V>
+void findAndEmplace(C& container,const V& targetVal, const V& insertVal) {
+    auto iter = std::find(std::cbegin(container),std::cend(container),targetVal); // use const_iterators Item 13 Effective Modern C++
+    container.emplace(iter,insertVal); // use emplace instead of insert Item 42 Effective Modern C++
+}
+
+
+// Benchmark: ns per insertion at a random position, ns per element to iterate
+
+template<typename C>
+std::pair<double, double> measure(size_t n, const std::vector<size_t>& positions)
+{
+    C container;
+    for (size_t i = 0; i < n; ++i) container.push_back(static_cast<int>(i));
+    const auto insertNs = bench::nsPerOp(positions.size(), [&] {
+        for (size_t i = 0; i < positions.size(); ++i) {
+            const size_t pos = positions[i] % (container.size() + 1);
+            if constexpr (std::is_same_v<C, ChunkedVector<int>>) container.insert(pos, -1);
+            else container.insert(container.begin() + pos, -1);
+        }
+    });
+    long long sum = 0;
+    const auto iterNs = bench::nsPerOp(container.size(), [&] { for (int value : container) sum += value; });
+    bench::keep(sum);
+    return {insertNs, iterNs};
+}
+
+void benchmark(size_t n)
+{
+    std::mt19937_64 gen{42};
+    std::vector<size_t> positions(std::max<size_t>(1000, std::min<size_t>(n / 10, 100'000)));
+    for (auto& pos : positions) pos = gen();
+
+    const auto vec = measure<std::vector<int>>(n, positions);
+    const auto deq = measure<std::deque<int>>(n, positions);
+    const auto chunked = measure<ChunkedVector<int>>(n, positions);
+    std::cout << std::setw(10) << n
+              << std::setw(12) << vec.first << std::setw(12) << deq.first << std::setw(12) << chunked.first
+              << std::setw(12) << vec.second << std::setw(12) << deq.second << std::setw(12) << chunked.second << "\n";
+}
+
+int main(int argc, char* argv[])
+{
+    // 1. findAndEmplace works unchanged
+    ChunkedVector<std::string> players {"Federer", "Djokovic", "Nadal"};
+    findAndEmplace(players, std::string{"Djokovic"}, std::string{"Wawrinka"});
+    for (const auto &player : players) {
+        std::cout << " " + (player) << "\n";
+    }
+
+    // 2. chunks are split when full: same content and same indexes as a vector after random insertions and erases
+    std::mt19937 gen{7};
+    ChunkedVector<int, 64> small;       // 16 ints per chunk: many splits
+    std::vector<int> reference;
+    for (int i = 0; i < 5000; ++i) {
+        const size_t pos = gen() % (reference.size() + 1);
+        if (i % 3 == 2 && !reference.empty()) {
+            const size_t erased = pos % reference.size();
+            reference.erase(reference.begin() + erased);
+            small.erase(std::next(small.cbegin(), erased));
+        }
+        else {
+            reference.insert(reference.begin() + pos, i);
+            small.insert(pos, i);
+        }
+    }
+    assert(std::equal(reference.begin(), reference.end(), small.begin(), small.end()));
+    for (size_t i = 0; i < reference.size(); ++i) assert(small[i] == reference[i]);
+    std::cout << small.size() << " elements in " << small.chunkCount() << " chunks, same as std::vector\n\n";
+
+    // 3. benchmark
+    const size_t maxSize = argc > 1 ? std::stoul(argv[1]) : 1'000'000;
+    std::cout << "            insert at random position (ns)        iterate (ns/element)\n";
+    std::cout << "      size      vector       deque     chunked      vector       deque     chunked\n";
+    for (size_t n = 10'000; n <= maxSize; n *= 10) {
+        benchmark(n);
+    }
+}
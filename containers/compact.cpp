@@ -0,0 +1,387 @@
+/*
+
+Stream compaction: erase_if / remove_if for big vectors and strings, order kept (stable).
+
+std::remove_if tests and moves the elements one by one with a branch per element: when about half of them
+are removed the branch is mispredicted all the time. For trivially copyable elements of 1 or 4 bytes:
+ - the predicate fills a bit mask for a block of elements (8 or 16 with AVX2/SSSE3, 16 or 64 with AVX-512)
+ - the kept elements are packed with one shuffle (AVX2 permutevar8x32, SSSE3 pshufb) or one
+   AVX-512 compress, stored at once, and the output moves forward by the number of bits set: no branch
+Other trivially copyable types use a branchless scalar loop, the others std::remove_if.
+The instruction set is selected once at runtime (__builtin_cpu_supports), no -mavx2 needed.
+
+Huge inputs (above kParallelThreshold elements) are cut in one chunk per thread, each chunk is compacted
+in place in parallel, then the chunks are stitched together (one memmove per chunk, in order).
+
+1) g++ -std=c++17 -O2 -Wall -pedantic compact.cpp -o compact -pthread -ltbb
+2) g++ -std=c++17 -O2 -Wall -pedantic -DNO_PAR_STL compact.cpp -o compact -pthread    // without TBB, no std::execution::par column
+3) ./compact 200    // benchmark on 200M ints and a 200MB string (default 50)
+
+*/
+
+#include "../common/bench.h"
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <random>
+#include <type_traits>
+#include <cstdint>
+#include <cstring>
+#include <cassert>
+
+#ifndef NO_PAR_STL
+#include <execution>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define COMPACT_SIMD_X86
+#endif
+
+
+namespace compact {
+
+constexpr size_t kParallelThreshold = 1 << 22;   // below, starting the threads costs more than it saves
+
+// 1. Kernels: compact [first, last) in place, return the new end
+
+namespace scalar {
+
+// the element is always written, the output only moves forward if it is kept (out <= first)
+template<typename T, typename Pred>
+T* removeIf(T* first, T* last, T* out, Pred pred) {
+    for (; first != last; ++first) {
+        const bool keep = !pred(*first);
+        *out = *first;
+        out += keep;
+    }
+    return out;
+}
+
+template<typename T, typename Pred>
+T* removeIf(T* first, T* last, Pred pred) { return removeIf(first, last, first, pred); }
+
+} // namespace scalar
+
+#ifdef COMPACT_SIMD_X86
+
+// shuffle tables: for each mask of kept elements, the indices of the kept ones packed to the front
+struct Lut {
+    Lut() {
+        for (unsigned mask = 0; mask < 256; ++mask) {
+            unsigned k = 0;
+            uint64_t bytes = 0;
+            for (unsigned i = 0; i < 8; ++i) {
+                if (mask & (1u << i)) {
+                    lanes32[mask][k] = i;
+                    bytes |= uint64_t{i} << (8 * k);
+                    ++k;
+                }
+            }
+            bytes8[mask] = bytes;
+        }
+    }
+    alignas(32) uint32_t lanes32[256][8] = {};
+    uint64_t bytes8[256];
+};
+
+inline const Lut& lut()
+{
+    static const Lut table;
+    return table;
+}
+
+// The vector stores write a whole block at out <= first: they only overwrite elements already read.
+// The predicate is called on the elements in memory, the kernels only move the bits around.
+
+namespace avx2 {
+
+#define AVX2_TARGET __attribute__((target("avx2,popcnt")))
+#define SSSE3_TARGET __attribute__((target("ssse3,popcnt")))
+
+// the predicate results go to a byte array first: that loop is vectorized when the predicate is simple,
+// an OR of shifted bits is not. movemask then gathers them in a bit mask
+template<typename T, typename Pred>
+SSSE3_TARGET unsigned keepMask16(const T* first, Pred pred) {
+    uint8_t flags[16];
+    for (unsigned i = 0; i < 16; ++i) flags[i] = !pred(first[i]);
+    const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(flags));
+    return static_cast<unsigned>(_mm_movemask_epi8(_mm_sub_epi8(_mm_setzero_si128(), bytes)));
+}
+
+template<typename T, typename Pred>
+AVX2_TARGET T* removeIf32(T* first, T* last, Pred pred) {
+    const auto& table = lut();
+    T* out = first;
+    for (; last - first >= 8; first += 8) {
+        unsigned keep = 0;      // 8 flags only: not worth the byte array
+        for (unsigned i = 0; i < 8; ++i) keep |= unsigned{!pred(first[i])} << i;
+        const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first));
+        const __m256i lanes = _mm256_load_si256(reinterpret_cast<const __m256i*>(table.lanes32[keep]));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_permutevar8x32_epi32(block, lanes));
+        out += __builtin_popcount(keep);
+    }
+    return scalar::removeIf(first, last, out, pred);    // tail
+}
+
+// 16 bytes: each half is packed with its own table entry, then both halves are stored one after the other
+template<typename T, typename Pred>
+SSSE3_TARGET T* removeIf8(T* first, T* last, Pred pred) {
+    const auto& table = lut();
+    T* out = first;
+    for (; last - first >= 16; first += 16) {
+        const unsigned keep = keepMask16(first, pred);
+        const unsigned lo = keep & 0xFF, hi = keep >> 8;
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+        const __m128i shuffle = _mm_add_epi8(_mm_set_epi64x(static_cast<int64_t>(table.bytes8[hi]), static_cast<int64_t>(table.bytes8[lo])),
+                                             _mm_set_epi64x(0x0808080808080808, 0));
+        const __m128i packed = _mm_shuffle_epi8(block, shuffle);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out), packed);
+        out += __builtin_popcount(lo);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out), _mm_unpackhi_epi64(packed, packed));
+        out += __builtin_popcount(hi);
+    }
+    return scalar::removeIf(first, last, out, pred);    // tail
+}
+
+} // namespace avx2
+
+namespace avx512 {
+
+#define AVX512_TARGET __attribute__((target("avx512f,popcnt")))
+#define AVX512_VBMI2_TARGET __attribute__((target("avx512f,avx512bw,avx512vbmi2,popcnt")))
+
+// maskz_compress + a full store: compressstoreu straight to memory is much slower on some CPUs
+template<typename T, typename Pred>
+AVX512_TARGET T* removeIf32(T* first, T* last, Pred pred) {
+    T* out = first;
+    for (; last - first >= 16; first += 16) {
+        const __mmask16 keep = avx2::keepMask16(first, pred);
+        const __m512i block = _mm512_loadu_si512(first);
+        _mm512_storeu_si512(out, _mm512_maskz_compress_epi32(keep, block));
+        out += __builtin_popcount(keep);
+    }
+    return scalar::removeIf(first, last, out, pred);    // tail
+}
+
+template<typename T, typename Pred>
+AVX512_VBMI2_TARGET T* removeIf8(T* first, T* last, Pred pred) {
+    T* out = first;
+    for (; last - first >= 64; first += 64) {
+        uint8_t flags[64];
+        for (unsigned i = 0; i < 64; ++i) flags[i] = !pred(first[i]);
+        const __mmask64 keep = _mm512_test_epi8_mask(_mm512_loadu_si512(flags), _mm512_loadu_si512(flags));
+        const __m512i block = _mm512_loadu_si512(first);
+        _mm512_storeu_si512(out, _mm512_maskz_compress_epi8(keep, block));
+        out += __builtin_popcountll(keep);
+    }
+    return scalar::removeIf(first, last, out, pred);    // tail
+}
+
+} // namespace avx512
+
+#endif // COMPACT_SIMD_X86
+
+enum class Isa { Scalar, Avx2, Avx512 };
+
+inline Isa detectIsa()
+{
+#ifdef COMPACT_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") &&
+        __builtin_cpu_supports("avx512vbmi2")) return Isa::Avx512;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt")) return Isa::Avx2;
+#endif
+    return Isa::Scalar;
+}
+
+inline Isa& isa()
+{
+    static Isa selected = detectIsa();
+    return selected;     // writable: the benchmark compares the instruction sets
+}
+
+inline const char* isaName(Isa set)
+{
+    switch (set) {
+    case Isa::Avx512: return "avx512";
+    case Isa::Avx2: return "avx2";
+    default: return "scalar";
+    }
+}
+
+
+// 2. Serial and parallel remove_if on a contiguous range
+
+template<typename T, typename Pred>
+T* removeIf(T* first, T* last, Pred pred)
+{
+    if constexpr (!std::is_trivially_copyable_v<T>) {
+        return std::remove_if(first, last, pred);
+    }
+    else {
+#ifdef COMPACT_SIMD_X86
+        if constexpr (sizeof(T) == 4) {
+            if (isa() == Isa::Avx512) return avx512::removeIf32(first, last, pred);
+            if (isa() == Isa::Avx2) return avx2::removeIf32(first, last, pred);
+        }
+        if constexpr (sizeof(T) == 1) {
+            if (isa() == Isa::Avx512) return avx512::removeIf8(first, last, pred);
+            if (isa() == Isa::Avx2) return avx2::removeIf8(first, last, pred);
+        }
+#endif
+        return scalar::removeIf(first, last, pred);
+    }
+}
+
+// one chunk per thread compacted in place, then the kept parts are moved down in order
+template<typename T, typename Pred>
+T* parallelRemoveIf(T* first, T* last, Pred pred, unsigned numThreads = std::thread::hardware_concurrency())
+{
+    const size_t size = last - first;
+    numThreads = std::max(1u, std::min<unsigned>(numThreads, static_cast<unsigned>(size / 1024 + 1)));
+    if (numThreads == 1) return removeIf(first, last, pred);
+
+    std::vector<T*> begins(numThreads), ends(numThreads);
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < numThreads; ++t) {
+        begins[t] = first + size * t / numThreads;
+        T* chunkLast = first + size * (t + 1) / numThreads;
+        threads.emplace_back([&, t, chunkLast] { ends[t] = removeIf(begins[t], chunkLast, pred); });
+    }
+    for (auto& thread : threads) thread.join();
+
+    // stitch: every chunk moves towards the front, a chunk may overlap the previous one so it is done in order
+    T* out = ends[0];
+    for (unsigned t = 1; t < numThreads; ++t) {
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            std::memmove(out, begins[t], (ends[t] - begins[t]) * sizeof(T));
+            out += ends[t] - begins[t];
+        }
+        else {
+            out = std::move(begins[t], ends[t], out);
+        }
+    }
+    return out;
+}
+
+
+// 3. erase_if / erase for std::vector and std::string, same return value as C++20 std::erase_if
+
+template<typename Container, typename Pred>
+size_t eraseIf(Container& container, Pred pred)
+{
+    auto first = container.data();
+    auto last = first + container.size();
+    auto end = container.size() >= kParallelThreshold ? parallelRemoveIf(first, last, pred) : removeIf(first, last, pred);
+    const size_t removed = last - end;
+    container.resize(end - first);
+    return removed;
+}
+
+template<typename Container, typename T>
+size_t erase(Container& container, const T& value)
+{
+    return eraseIf(container, [&value](const auto& elem) { return elem == value; });
+}
+
+} // namespace compact
+
+
+void disp(const std::vector<int>& vec)
+{
+    std::cout << "{";
+    for(const auto& el : vec )
+    {
+        std::cout << el << " ,";
+    }
+    std::cout << "}\n";
+}
+
+
+// 4. Benchmark: ms to remove x% of the elements
+
+// every variant runs on a fresh copy of source and must give the same result
+template<typename Container, typename Pred>
+void benchmark(const char* name, const Container& source, int percent, Pred pred)
+{
+    Container expected = source;
+    Container work;
+    auto reset = [&] { work = source; };
+
+    expected.erase(std::remove_if(expected.begin(), expected.end(), pred), expected.end());
+    reset();
+    const auto stdMs = bench::msFor([&] { work.erase(std::remove_if(work.begin(), work.end(), pred), work.end()); });
+#ifndef NO_PAR_STL
+    reset();
+    const auto parMs = bench::msFor([&] { work.erase(std::remove_if(std::execution::par, work.begin(), work.end(), pred), work.end()); });
+    assert(work == expected);
+#endif
+    std::cout << std::setw(8) << name << std::setw(7) << percent << "%" << std::setw(13) << stdMs;
+#ifndef NO_PAR_STL
+    std::cout << std::setw(13) << parMs;
+#endif
+    const auto best = compact::isa();
+    for (auto set : {compact::Isa::Scalar, compact::Isa::Avx2, compact::Isa::Avx512}) {
+        if (set > best) {
+            std::cout << std::setw(13) << "-";
+            continue;
+        }
+        compact::isa() = set;
+        reset();
+        const auto ms = bench::msFor([&] {
+            auto first = work.data();
+            work.resize(compact::removeIf(first, first + work.size(), pred) - first);
+        });
+        assert(work == expected);
+        std::cout << std::setw(13) << ms;
+    }
+    compact::isa() = best;
+    reset();
+    const auto parallelMs = bench::msFor([&] {
+        auto first = work.data();
+        work.resize(compact::parallelRemoveIf(first, first + work.size(), pred) - first);
+    });
+    assert(work == expected);
+    std::cout << std::setw(13) << parallelMs << "\n";
+}
+
+int main(int argc, char* argv[])
+{
+    // 1. same usage as rm_vectors_strings.cpp
+    std::vector<int> myvec{1, 2, 3, 4, 5, 6, 7, 8, 8, 9, 9, -1, -2, 7};
+    std::string mystr{"Hi Folks !  !"};
+    compact::erase(myvec, 7);
+    compact::erase(mystr, '!');
+    auto negativeNumber = [](auto const & elem) { return elem < 0;};
+    const size_t removed = compact::eraseIf(myvec, negativeNumber);
+    std::cout << "removed " << removed << " negative numbers and all the 7: ";
+    disp(myvec);
+    std::cout << mystr << "\n\n";
+
+    // 2. benchmark
+    const size_t millions = argc > 1 ? std::stoul(argv[1]) : 50;
+    std::mt19937 gen{42};
+    std::vector<int> ints(millions * 1'000'000);
+    for (auto& i : ints) i = static_cast<int>(gen() % 100);
+    std::string bytes(millions * 1'000'000, '\0');
+    for (auto& c : bytes) c = static_cast<char>(gen());
+
+    std::cout << "isa: " << compact::isaName(compact::isa()) << ", threads: " << std::thread::hardware_concurrency() << "\n";
+    std::cout << "    type  removed  remove_if ms";
+#ifndef NO_PAR_STL
+    std::cout << "   par STL ms";
+#endif
+    std::cout << "    scalar ms      avx2 ms    avx512 ms  parallel ms\n";
+    for (int percent : {1, 10, 50, 90, 99}) {
+        benchmark("int", ints, percent, [percent](int i) { return i < percent; });
+    }
+    for (int percent : {1, 10, 50, 90, 99}) {
+        const int cutoff = percent * 256 / 100;
+        benchmark("char", bytes, percent, [cutoff](char c) { return static_cast<unsigned char>(c) < cutoff; });
+    }
+}
@@ -0,0 +1,338 @@
+/*
+
+FlatMap: a sorted associative container stored in 2 contiguous arrays (keys and values) instead of one node per element.
+ - lookup is a binary search over the keys only: cache friendly, no pointer chasing
+ - iteration is a linear scan of 2 arrays
+ - insert/erase in the middle move the elements after it: O(n). Use the bulk insert (one sort + one merge) to build it
+
+Good fit for read mostly tables. Same interface as std::map for what add_maps.cpp and rm_maps.cpp use:
+operator[], insert, emplace, try_emplace, insert_or_assign, erase (key, iterator, range) and erase_if.
+Like std::vector, any insertion or erase invalidates the iterators.
+
+1) g++ -std=c++17 -O2 -Wall -pedantic flat_map.cpp -o flat_map
+2) ./flat_map 10000000    // benchmark from 1K up to 10M entries (default 1M)
+
+*/
+
+#include "../common/bench.h"
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <utility>
+#include <stdexcept>
+#include <random>
+#include <cassert>
+
+
+template<typename Key, typename T, typename Compare = std::less<Key>>
+class FlatMap {
+ public:
+    using key_type = Key;
+    using mapped_type = T;
+    using value_type = std::pair<Key, T>;
+    using size_type = size_t;
+
+    // *it gives a pair of references on the 2 arrays: works with it->second and auto& [key, value]
+    template<bool Const>
+    class Iterator {
+     public:
+        using map_type = std::conditional_t<Const, const FlatMap, FlatMap>;
+        using reference = std::pair<const Key&, std::conditional_t<Const, const T&, T&>>;
+        using value_type = FlatMap::value_type;
+        using difference_type = std::ptrdiff_t;
+        using iterator_category = std::random_access_iterator_tag;
+
+        struct pointer {    // operator-> must return something with an operator->
+            reference ref;
+            const reference* operator->() const { return &ref; }
+        };
+
+        Iterator() = default;
+        Iterator(map_type* map, size_t pos):m_map{map},m_pos{pos} {}
+        operator Iterator<true>() const { return {m_map, m_pos}; }
+
+        reference operator*() const { return {m_map->m_keys[m_pos], m_map->m_values[m_pos]}; }
+        pointer operator->() const { return {**this}; }
+
+        Iterator& operator++() { ++m_pos; return *this; }
+        Iterator operator++(int) { auto tmp = *this; ++m_pos; return tmp; }
+        Iterator& operator--() { --m_pos; return *this; }
+        Iterator operator--(int) { auto tmp = *this; --m_pos; return tmp; }
+        Iterator& operator+=(difference_type n) { m_pos += n; return *this; }
+        Iterator operator+(difference_type n) const { return {m_map, m_pos + n}; }
+        Iterator operator-(difference_type n) const { return {m_map, m_pos - n}; }
+        difference_type operator-(const Iterator& other) const { return difference_type(m_pos) - difference_type(other.m_pos); }
+
+        bool operator==(const Iterator& other) const { return m_pos == other.m_pos; }
+        bool operator!=(const Iterator& other) const { return m_pos != other.m_pos; }
+        bool operator<(const Iterator& other) const { return m_pos < other.m_pos; }
+
+        size_t index() const { return m_pos; }
+
+     private:
+        map_type* m_map = nullptr;
+        size_t m_pos = 0;
+    };
+
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    FlatMap() = default;
+    explicit FlatMap(const Compare& cmp):m_cmp{cmp} {}
+    FlatMap(std::initializer_list<value_type> init) { insert(init.begin(), init.end()); }
+
+    iterator begin() { return {this, 0}; }
+    iterator end() { return {this, size()}; }
+    const_iterator begin() const { return {this, 0}; }
+    const_iterator end() const { return {this, size()}; }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+    size_t size() const { return m_keys.size(); }
+    bool empty() const { return m_keys.empty(); }
+    void clear() { m_keys.clear(); m_values.clear(); }
+    void reserve(size_t n) { m_keys.reserve(n); m_values.reserve(n); }
+
+    iterator find(const Key& key) { return {this, findIndex(key)}; }
+    const_iterator find(const Key& key) const { return {this, findIndex(key)}; }
+    bool contains(const Key& key) const { return findIndex(key) != size(); }
+    size_t count(const Key& key) const { return contains(key) ? 1 : 0; }
+
+    // heterogeneous lookup (e.g. a std::string_view for std::string keys) if Compare is transparent like std::less<>
+    template<typename K, typename C = Compare, typename = typename C::is_transparent>
+    iterator find(const K& key) { return {this, findIndex(key)}; }
+    template<typename K, typename C = Compare, typename = typename C::is_transparent>
+    const_iterator find(const K& key) const { return {this, findIndex(key)}; }
+    template<typename K, typename C = Compare, typename = typename C::is_transparent>
+    bool contains(const K& key) const { return findIndex(key) != size(); }
+
+    T& at(const Key& key) {
+        auto pos = lowerBoundIndex(key);
+        if (!found(pos, key)) throw std::out_of_range{"FlatMap::at: key not found"};
+        return m_values[pos];
+    }
+    const T& at(const Key& key) const { return const_cast<FlatMap*>(this)->at(key); }
+
+    T& operator[](const Key& key) { return try_emplace(key).first->second; }
+    T& operator[](Key&& key) { return try_emplace(std::move(key)).first->second; }
+
+    // single element insertion: O(log n) search + O(n) move of the following elements
+    std::pair<iterator, bool> insert(const value_type& value) { return try_emplace(value.first, value.second); }
+    std::pair<iterator, bool> insert(value_type&& value) { return try_emplace(std::move(value.first), std::move(value.second)); }
+    template<typename P, typename = std::enable_if_t<std::is_constructible_v<value_type, P&&>>>
+    std::pair<iterator, bool> insert(P&& value) { return insert(value_type(std::forward<P>(value))); }
+
+    template<typename... Args>
+    std::pair<iterator, bool> emplace(Args&&... args) { return insert(value_type(std::forward<Args>(args)...)); }
+
+    // the arguments are untouched (not moved from) if the key already exists
+    template<typename... Args>
+    std::pair<iterator, bool> try_emplace(const Key& key, Args&&... args) { return tryEmplace(key, std::forward<Args>(args)...); }
+    template<typename... Args>
+    std::pair<iterator, bool> try_emplace(Key&& key, Args&&... args) { return tryEmplace(std::move(key), std::forward<Args>(args)...); }
+
+    template<typename M>
+    std::pair<iterator, bool> insert_or_assign(const Key& key, M&& obj) {
+        auto [iter, inserted] = try_emplace(key, std::forward<M>(obj));
+        if (!inserted) m_values[iter.index()] = std::forward<M>(obj);
+        return {iter, inserted};
+    }
+
+    // bulk insertion: sort the new elements once then merge them with the current ones, O(m log m + n)
+    // (the first occurrence of a key wins, like a sequence of insert())
+    template<typename InputIt>
+    void insert(InputIt first, InputIt last);
+
+    size_t erase(const Key& key) {
+        auto pos = lowerBoundIndex(key);
+        if (!found(pos, key)) return 0;
+        erase(begin() + pos);
+        return 1;
+    }
+    iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
+    iterator erase(const_iterator first, const_iterator last) {
+        m_keys.erase(m_keys.begin() + first.index(), m_keys.begin() + last.index());
+        m_values.erase(m_values.begin() + first.index(), m_values.begin() + last.index());
+        return {this, first.index()};
+    }
+
+    // one single compaction pass over both arrays whatever the number of removed elements
+    template<typename Pred>
+    friend size_t erase_if(FlatMap& map, Pred pred) {
+        size_t kept = 0;
+        for (size_t i = 0; i < map.size(); ++i) {
+            if (!pred(std::pair<const Key&, T&>{map.m_keys[i], map.m_values[i]})) {
+                if (kept != i) {
+                    map.m_keys[kept] = std::move(map.m_keys[i]);
+                    map.m_values[kept] = std::move(map.m_values[i]);
+                }
+                ++kept;
+            }
+        }
+        const size_t removed = map.size() - kept;
+        map.m_keys.resize(kept);
+        map.m_values.resize(kept);
+        return removed;
+    }
+
+ private:
+    template<typename K>
+    size_t lowerBoundIndex(const K& key) const {
+        return std::lower_bound(m_keys.begin(), m_keys.end(), key, m_cmp) - m_keys.begin();
+    }
+    template<typename K>
+    bool found(size_t pos, const K& key) const { return pos != size() && !m_cmp(key, m_keys[pos]); }
+    template<typename K>
+    size_t findIndex(const K& key) const { auto pos = lowerBoundIndex(key); return found(pos, key) ? pos : size(); }
+
+    template<typename K, typename... Args>
+    std::pair<iterator, bool> tryEmplace(K&& key, Args&&... args);
+
+    std::vector<Key> m_keys;
+    std::vector<T> m_values;
+    Compare m_cmp;
+};
+
+template<typename Key, typename T, typename Compare>
+template<typename K, typename... Args>
+std::pair<typename FlatMap<Key, T, Compare>::iterator, bool> FlatMap<Key, T, Compare>::tryEmplace(K&& key, Args&&... args)
+{
+    auto pos = lowerBoundIndex(key);
+    if (found(pos, key)) return {iterator{this, pos}, false};
+    m_keys.insert(m_keys.begin() + pos, Key(std::forward<K>(key)));
+    try {
+        m_values.insert(m_values.begin() + pos, T(std::forward<Args>(args)...));
+    }
+    catch (...) {
+        m_keys.erase(m_keys.begin() + pos);   // keep both arrays in sync
+        throw;
+    }
+    return {iterator{this, pos}, true};
+}
+
+template<typename Key, typename T, typename Compare>
+template<typename InputIt>
+void FlatMap<Key, T, Compare>::insert(InputIt first, InputIt last)
+{
+    std::vector<value_type> added(first, last);
+    auto byKey = [this](const value_type& lhs, const value_type& rhs) { return m_cmp(lhs.first, rhs.first); };
+    std::stable_sort(added.begin(), added.end(), byKey);
+    added.erase(std::unique(added.begin(), added.end(), [this](const value_type& lhs, const value_type& rhs) {
+        return !m_cmp(lhs.first, rhs.first) && !m_cmp(rhs.first, lhs.first);
+    }), added.end());
+
+    // merge the 2 sorted sequences into new arrays, an existing key wins
+    std::vector<Key> keys;
+    std::vector<T> values;
+    keys.reserve(size() + added.size());
+    values.reserve(size() + added.size());
+    size_t i = 0;
+    auto addIt = added.begin();
+    while (i < size() || addIt != added.end()) {
+        if (addIt == added.end() || (i < size() && !m_cmp(addIt->first, m_keys[i]))) {
+            if (addIt != added.end() && !m_cmp(m_keys[i], addIt->first)) ++addIt;    // same key: keep the existing one
+            keys.push_back(std::move(m_keys[i]));
+            values.push_back(std::move(m_values[i]));
+            ++i;
+        }
+        else {
+            keys.push_back(std::move(addIt->first));
+            values.push_back(std::move(addIt->second));
+            ++addIt;
+        }
+    }
+    m_keys = std::move(keys);
+    m_values = std::move(values);
+}
+
+
+template <typename M>
+void disp(const M& container){
+    std::cout << "{ ";
+    for (const auto& [key,value] : container) {
+        std::cout << key << " : " << value << ", ";
+    }
+    std::cout << "}\n";
+}
+
+
+// Benchmark
+
+void benchmark(size_t n)
+{
+    std::mt19937 gen{42};
+    std::uniform_int_distribution<int> dist;
+    std::vector<std::pair<int, int>> pairs(n);
+    for (auto& p : pairs) p = {dist(gen), dist(gen)};
+    std::vector<int> queries(std::min<size_t>(n, 1'000'000));
+    for (auto& q : queries) q = pairs[dist(gen) % n].first;   // hits
+
+    std::map<int, int> map;
+    FlatMap<int, int> flat;
+    auto buildMap = bench::nsPerOp(n, [&] { map.insert(pairs.begin(), pairs.end()); });
+    auto buildFlat = bench::nsPerOp(n, [&] { flat.insert(pairs.begin(), pairs.end()); });
+    assert(map.size() == flat.size());
+
+    long long sumMap = 0, sumFlat = 0;
+    auto findMap = bench::nsPerOp(queries.size(), [&] { for (int q : queries) sumMap += map.find(q)->second; });
+    auto findFlat = bench::nsPerOp(queries.size(), [&] { for (int q : queries) sumFlat += flat.find(q)->second; });
+    auto iterMap = bench::nsPerOp(n, [&] { for (const auto& [key, value] : map) sumMap += value; });
+    auto iterFlat = bench::nsPerOp(n, [&] { for (const auto& [key, value] : flat) sumFlat += value; });
+    assert(sumMap == sumFlat);
+
+    std::cout << std::setw(10) << n
+              << std::setw(11) << buildMap << std::setw(11) << buildFlat
+              << std::setw(11) << findMap << std::setw(11) << findFlat
+              << std::setw(11) << iterMap << std::setw(11) << iterFlat << "\n";
+}
+
+int main(int argc, char* argv[])
+{
+    // 1. same usage as add_maps.cpp
+    FlatMap<std::string, int> phone_book { {"John", 124}, {"Mary", 345}, {"Marc", 345}, };
+    phone_book["Leon"] = 4;
+    phone_book["Leon"] += 2;
+    phone_book.insert(std::pair{"Marc", 6});                // do not overwrite
+    if(auto [iter , succeed] = phone_book.insert({"Marc", 7}); succeed == false) {
+        std::cout << "Marc already there: " << iter->second << "\n";
+    }
+    phone_book.emplace("Gianna", 799);
+    phone_book.try_emplace("Ben", 47);
+    phone_book.try_emplace("Ben", 8);                       // do not overwrite
+    auto [it, insert] = phone_book.insert_or_assign("Ben", 4864654);
+    assert(insert == false && it->second == 4864654);
+    disp(phone_book);
+    FlatMap<std::string, int, std::less<>> transparent{{"John", 124}};
+    std::cout << "found John without creating a std::string: " << std::boolalpha
+              << transparent.contains(std::string_view{"John"}) << "\n";
+
+    // 2. same usage as rm_maps.cpp
+    FlatMap<int, int> mymap {{1, 10}, {2, 20}, {3, 30}, {4, 40}, {5, 50}, {6, 60}, {7, 70}, {8, 80}};
+    mymap.erase(5);
+    mymap.erase(mymap.begin());
+    auto start = mymap.begin() + 2;
+    mymap.erase(start, start + 2);
+    disp(mymap);
+    auto predEvenKey = [](auto const& elem){ auto const [key, val] = elem; return key % 2 == 0;};
+    erase_if(mymap, predEvenKey);
+    disp(mymap);
+
+    // 3. bulk insertion, sorted once
+    std::vector<std::pair<int, int>> bulk {{9, 90}, {3, 0}, {1, 10}, {9, 0}, {2, 20}};
+    mymap.insert(bulk.begin(), bulk.end());
+    disp(mymap);
+
+    // 4. benchmark in ns per element
+    const size_t maxSize = argc > 1 ? std::stoul(argv[1]) : 1'000'000;
+    std::cout << "\n      size  build map build flat   find map  find flat   iter map  iter flat\n";
+    for (size_t n = 1000; n <= maxSize; n *= 10) {
+        benchmark(n);
+    }
+}
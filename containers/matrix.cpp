@@ -0,0 +1,300 @@
+/*
+
+Matrix<T>: a dense 2D array in one single row-major buffer, instead of vector<vector<T>> (vector.cpp, 8.)
+where every row is its own allocation somewhere in memory and each access goes through 2 pointers.
+ - element (r, c) is at data[r * stride + c]: rows follow each other, the hardware prefetcher can follow
+ - stride >= cols: with Padding::SimdRows every row starts on a 64 bytes boundary (one cache line, AVX-512 width)
+ - row(), col() and sub() return non owning views (pointer + sizes + stride), nothing is copied
+ - transpose() works on square tiles that fit in L1: the reads and the writes both stay in cache
+ - forEachTile() walks a view tile by tile, for the same reason
+
+Matrix is meant for arithmetic types (trivially copyable): the storage is not constructed element by element.
+
+1) g++ -std=c++17 -O2 -Wall -pedantic matrix.cpp -o matrix
+2) ./matrix 8192    // benchmark from 256x256 up to 8192x8192 ints (default 4096)
+
+*/
+
+#include "../common/bench.h"
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <memory>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+#include <cstdlib>
+#include <cassert>
+
+
+constexpr size_t kAlignment = 64;
+
+// n elements, every stride elements: a row (stride 1) or a column (stride of the matrix)
+template<typename T>
+class StridedView {
+ public:
+    StridedView(T* data, size_t size, size_t stride):m_data{data},m_size{size},m_stride{stride} {}
+
+    T& operator[](size_t i) const { return m_data[i * m_stride]; }
+    size_t size() const { return m_size; }
+    T* data() const { return m_data; }
+
+    class Iterator {
+     public:
+        using value_type = std::remove_const_t<T>;
+        using reference = T&;
+        using pointer = T*;
+        using difference_type = std::ptrdiff_t;
+        using iterator_category = std::forward_iterator_tag;
+
+        Iterator(T* ptr, size_t stride):m_ptr{ptr},m_stride{stride} {}
+        T& operator*() const { return *m_ptr; }
+        Iterator& operator++() { m_ptr += m_stride; return *this; }
+        bool operator==(const Iterator& other) const { return m_ptr == other.m_ptr; }
+        bool operator!=(const Iterator& other) const { return m_ptr != other.m_ptr; }
+
+     private:
+        T* m_ptr;
+        size_t m_stride;
+    };
+
+    Iterator begin() const { return {m_data, m_stride}; }
+    Iterator end() const { return {m_data + m_size * m_stride, m_stride}; }
+
+ private:
+    T* m_data;
+    size_t m_size;
+    size_t m_stride;
+};
+
+// non owning rows x cols window on a row-major buffer
+template<typename T>
+class MatrixView {
+ public:
+    MatrixView(T* data, size_t rows, size_t cols, size_t stride):m_data{data},m_rows{rows},m_cols{cols},m_stride{stride} {}
+    operator MatrixView<const T>() const { return {m_data, m_rows, m_cols, m_stride}; }
+
+    T& operator()(size_t r, size_t c) const { return m_data[r * m_stride + c]; }
+    T& at(size_t r, size_t c) const {
+        if (r >= m_rows || c >= m_cols) throw std::out_of_range{"Matrix::at: index out of range"};
+        return (*this)(r, c);
+    }
+
+    StridedView<T> row(size_t r) const { return {m_data + r * m_stride, m_cols, 1}; }
+    StridedView<T> col(size_t c) const { return {m_data + c, m_rows, m_stride}; }
+    MatrixView sub(size_t r, size_t c, size_t rows, size_t cols) const {
+        if (r + rows > m_rows || c + cols > m_cols) throw std::out_of_range{"Matrix::sub: view out of the matrix"};
+        return {m_data + r * m_stride + c, rows, cols, m_stride};
+    }
+
+    size_t rows() const { return m_rows; }
+    size_t cols() const { return m_cols; }
+    size_t stride() const { return m_stride; }
+    T* data() const { return m_data; }
+
+ private:
+    T* m_data;
+    size_t m_rows;
+    size_t m_cols;
+    size_t m_stride;
+};
+
+enum class Padding { None, SimdRows };
+
+template<typename T>
+class Matrix {
+    static_assert(std::is_trivially_copyable_v<T>, "Matrix: trivially copyable element type required");
+
+ public:
+    Matrix() = default;
+    Matrix(size_t rows, size_t cols, Padding padding = Padding::None, T value = T{})
+    :m_rows{rows},m_cols{cols},m_stride{padding == Padding::SimdRows ? paddedStride(cols) : cols},m_data{allocate(rows * m_stride)}
+    {
+        std::fill(m_data.get(), m_data.get() + rows * m_stride, value);
+    }
+    Matrix(std::initializer_list<std::initializer_list<T>> init)
+    :Matrix(init.size(), init.size() == 0 ? 0 : init.begin()->size())
+    {
+        size_t r = 0;
+        for (const auto& row : init) {
+            if (row.size() != m_cols) throw std::invalid_argument{"Matrix: rows of different sizes"};
+            std::copy(row.begin(), row.end(), m_data.get() + r++ * m_stride);
+        }
+    }
+
+    Matrix(const Matrix& other):m_rows{other.m_rows},m_cols{other.m_cols},m_stride{other.m_stride},m_data{allocate(m_rows * m_stride)} {
+        std::copy(other.m_data.get(), other.m_data.get() + m_rows * m_stride, m_data.get());
+    }
+    Matrix& operator=(const Matrix& other) {
+        if (this != &other) *this = Matrix{other};
+        return *this;
+    }
+    Matrix(Matrix&&) noexcept = default;
+    Matrix& operator=(Matrix&&) noexcept = default;
+
+    T& operator()(size_t r, size_t c) { return m_data[r * m_stride + c]; }
+    const T& operator()(size_t r, size_t c) const { return m_data[r * m_stride + c]; }
+    T& at(size_t r, size_t c) { return view().at(r, c); }
+    const T& at(size_t r, size_t c) const { return view().at(r, c); }
+
+    MatrixView<T> view() { return {m_data.get(), m_rows, m_cols, m_stride}; }
+    MatrixView<const T> view() const { return {m_data.get(), m_rows, m_cols, m_stride}; }
+    StridedView<T> row(size_t r) { return view().row(r); }
+    StridedView<const T> row(size_t r) const { return view().row(r); }
+    StridedView<T> col(size_t c) { return view().col(c); }
+    StridedView<const T> col(size_t c) const { return view().col(c); }
+    MatrixView<T> sub(size_t r, size_t c, size_t rows, size_t cols) { return view().sub(r, c, rows, cols); }
+    MatrixView<const T> sub(size_t r, size_t c, size_t rows, size_t cols) const { return view().sub(r, c, rows, cols); }
+
+    size_t rows() const { return m_rows; }
+    size_t cols() const { return m_cols; }
+    size_t stride() const { return m_stride; }
+    T* data() { return m_data.get(); }
+    const T* data() const { return m_data.get(); }
+
+    Matrix transposed() const;
+
+ private:
+    struct Free { void operator()(T* ptr) const { std::free(ptr); } };
+
+    static size_t paddedStride(size_t cols) {
+        const size_t perLine = std::max<size_t>(1, kAlignment / sizeof(T));
+        const size_t stride = (cols + perLine - 1) / perLine * perLine;
+        // a row of a multiple of 4KB maps every element of a column to the same L1 set:
+        // one more cache line per row spreads them over all the sets
+        return stride * sizeof(T) % 4096 == 0 ? stride + perLine : stride;
+    }
+
+    static std::unique_ptr<T[], Free> allocate(size_t count) {
+        if (count == 0) return nullptr;
+        // aligned_alloc requires a size multiple of the alignment
+        const size_t bytes = (count * sizeof(T) + kAlignment - 1) / kAlignment * kAlignment;
+        auto data = static_cast<T*>(std::aligned_alloc(kAlignment, bytes));
+        if (data == nullptr) throw std::bad_alloc{};
+        return std::unique_ptr<T[], Free>{data};
+    }
+
+    size_t m_rows = 0;
+    size_t m_cols = 0;
+    size_t m_stride = 0;
+    std::unique_ptr<T[], Free> m_data;
+};
+
+
+// 1. Tiled iteration and cache-blocked transpose
+
+// calls f(tile, firstRow, firstCol) for every tile, row of tiles by row of tiles. Border tiles are smaller
+template<typename T, typename F>
+void forEachTile(MatrixView<T> view, size_t tileRows, size_t tileCols, F&& f)
+{
+    for (size_t r = 0; r < view.rows(); r += tileRows) {
+        for (size_t c = 0; c < view.cols(); c += tileCols) {
+            f(view.sub(r, c, std::min(tileRows, view.rows() - r), std::min(tileCols, view.cols() - c)), r, c);
+        }
+    }
+}
+
+// a tile of kTile x kTile is read row by row and written column by column: both fit in L1
+// (32 x 32 ints = 4KB each), so every cache line loaded is used completely before being evicted
+template<typename T>
+void transpose(MatrixView<const T> src, MatrixView<T> dst)
+{
+    constexpr size_t kTile = std::max<size_t>(8, 128 / sizeof(T));
+    if (dst.rows() != src.cols() || dst.cols() != src.rows()) throw std::invalid_argument{"transpose: wrong destination size"};
+    forEachTile(src, kTile, kTile, [&](MatrixView<const T> tile, size_t r0, size_t c0) {
+        for (size_t r = 0; r < tile.rows(); ++r) {
+            for (size_t c = 0; c < tile.cols(); ++c) {
+                dst(c0 + c, r0 + r) = tile(r, c);
+            }
+        }
+    });
+}
+
+template<typename T>
+Matrix<T> Matrix<T>::transposed() const
+{
+    Matrix result(m_cols, m_rows, m_stride != m_cols ? Padding::SimdRows : Padding::None);
+    transpose(view(), result.view());
+    return result;
+}
+
+template<typename T>
+void disp(MatrixView<T> view)
+{
+    for (size_t r = 0; r < view.rows(); ++r) {
+        std::cout << "{ ";
+        for (const auto& val : view.row(r)) std::cout << val << ", ";
+        std::cout << "}\n";
+    }
+    std::cout << "\n";
+}
+
+
+// 2. Benchmark: ns per element, Matrix<int> vs vector<vector<int>>
+
+void benchmark(size_t n)
+{
+    using Nested = std::vector<std::vector<int>>;
+    Nested nested(n, std::vector<int>(n));
+    Matrix<int> matrix(n, n, Padding::SimdRows);
+    for (size_t r = 0; r < n; ++r) {
+        for (size_t c = 0; c < n; ++c) nested[r][c] = matrix(r, c) = static_cast<int>(r * n + c);
+    }
+    const size_t count = n * n;
+    long long sum = 0;
+
+    const auto rowsNested = bench::nsPerOp(count, [&] { for (const auto& row : nested) for (int v : row) sum += v; });
+    const auto rowsMatrix = bench::nsPerOp(count, [&] { for (size_t r = 0; r < n; ++r) for (int v : matrix.row(r)) sum += v; });
+    const auto colsNested = bench::nsPerOp(count, [&] { for (size_t c = 0; c < n; ++c) for (size_t r = 0; r < n; ++r) sum += nested[r][c]; });
+    const auto colsMatrix = bench::nsPerOp(count, [&] { for (size_t c = 0; c < n; ++c) for (int v : matrix.col(c)) sum += v; });
+    // the column scan again, by tiles of 64 rows x 16 columns (4KB): the 64 cache lines of a tile are loaded
+    // for the first column and reused for the 15 others
+    const auto colsTiled = bench::nsPerOp(count, [&] {
+        forEachTile(matrix.view(), 64, 16, [&](MatrixView<int> tile, size_t, size_t) {
+            for (size_t c = 0; c < tile.cols(); ++c) for (int v : tile.col(c)) sum += v;
+        });
+    });
+
+    Nested nestedT(n, std::vector<int>(n));
+    Matrix<int> matrixT(n, n, Padding::SimdRows);
+    const auto transNested = bench::nsPerOp(count, [&] {
+        for (size_t r = 0; r < n; ++r) for (size_t c = 0; c < n; ++c) nestedT[c][r] = nested[r][c];
+    });
+    const auto transNaive = bench::nsPerOp(count, [&] {
+        for (size_t r = 0; r < n; ++r) for (size_t c = 0; c < n; ++c) matrixT(c, r) = matrix(r, c);
+    });
+    const auto transBlocked = bench::nsPerOp(count, [&] { transpose(std::as_const(matrix).view(), matrixT.view()); });
+    assert(matrixT(1, 0) == nestedT[1][0] && matrixT(n - 1, 0) == static_cast<int>(n - 1));
+    bench::keep(sum);
+
+    std::cout << std::setw(6) << n << std::setw(9) << rowsNested << std::setw(9) << rowsMatrix
+              << std::setw(9) << colsNested << std::setw(9) << colsMatrix << std::setw(9) << colsTiled
+              << std::setw(9) << transNested << std::setw(9) << transNaive << std::setw(9) << transBlocked << "\n";
+}
+
+int main(int argc, char* argv[])
+{
+    // 1. same usage as vector.cpp, 8. vector of vector
+    Matrix<int> v3 = {{1, 2, 3}, {4 ,5 ,6}};
+    std::cout << v3(1, 1) << " " << v3.at(0, 1) << "\n";
+    std::cout << "column 2: ";
+    for (int v : v3.col(2)) std::cout << v << " ";
+    std::cout << "\n";
+    disp(v3.transposed().view());
+
+    Matrix<int> padded(3, 5, Padding::SimdRows, 7);
+    std::cout << "3x5 padded to a stride of " << padded.stride() << " ints\n";
+    auto window = padded.sub(1, 1, 2, 3);
+    window(0, 0) = 0;
+    disp(std::as_const(padded).view());
+
+    // 2. benchmark
+    const size_t maxSize = argc > 1 ? std::stoul(argv[1]) : 4096;
+    std::cout << "                  row scan          column scan                  transpose\n";
+    std::cout << "     n   nested   Matrix   nested   Matrix    tiled   nested    naive  blocked  (ns/element)\n";
+    for (size_t n = 256; n <= maxSize; n *= 2) {
+        benchmark(n);
+    }
+}
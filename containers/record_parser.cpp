@@ -0,0 +1,229 @@
+/*
+
+Streaming parser for delimited records ("123:456,abc\n") over big files.
+Instead of one std::string per line and one per field (getline + istringstream), the file is read by chunks
+into one reusable buffer and every field is a std::string_view into this buffer:
+ - no allocation per record or per field
+ - delimiters and end of line are found in one single pass, 16 bytes at a time with SSE2
+ - a record straddling 2 chunks is moved to the front of the buffer before reading the next chunk
+
+Fields are only valid until the next call to next(): copy them if you need to keep them.
+
+1) g++ -std=c++17 -O2 -Wall -pedantic record_parser.cpp -o record_parser
+2) ./record_parser 1000    // benchmark on a 1000MB generated file (default 200MB)
+
+*/
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <cstdio>
+#include <stdexcept>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+
+class RecordReader {
+ public:
+    static constexpr size_t kMaxDelimiters = 4;
+
+    explicit RecordReader(std::istream& in, std::string_view delimiters = ":,", char eol = '\n', size_t chunkSize = 1 << 20);
+
+    // read the next record, false at the end of the stream. The views are valid until the next call
+    bool next(std::vector<std::string_view>& fields);
+
+ private:
+    const char* findSpecial(const char* first, const char* last) const;
+    void refill(size_t keepFrom);
+
+    std::istream& m_in;
+    std::array<char, kMaxDelimiters> m_delims{};
+    size_t m_numDelims;
+    char m_eol;
+    std::array<bool, 256> m_isSpecial{};  // delimiters + eol, for the scalar tail
+    std::vector<char> m_buffer;
+    size_t m_pos = 0;                     // next unread byte
+    size_t m_end = 0;                     // end of valid data
+    bool m_eof = false;
+};
+
+RecordReader::RecordReader(std::istream& in, std::string_view delimiters, char eol, size_t chunkSize)
+:m_in{in},m_numDelims{delimiters.size()},m_eol{eol},m_buffer(chunkSize)
+{
+    if (delimiters.size() > kMaxDelimiters) {
+        throw std::invalid_argument{"RecordReader: too many delimiters"};
+    }
+    std::copy(delimiters.begin(), delimiters.end(), m_delims.begin());
+    for (char c : delimiters) m_isSpecial[static_cast<unsigned char>(c)] = true;
+    m_isSpecial[static_cast<unsigned char>(eol)] = true;
+}
+
+// first delimiter or end of line in [first, last), last if none
+const char* RecordReader::findSpecial(const char* first, const char* last) const
+{
+    if (m_numDelims == 0) {
+        auto found = static_cast<const char*>(std::memchr(first, m_eol, last - first));
+        return found != nullptr ? found : last;
+    }
+#if defined(__SSE2__)
+    const __m128i eol = _mm_set1_epi8(m_eol);
+    __m128i delims[kMaxDelimiters];
+    for (size_t d = 0; d < m_numDelims; ++d) delims[d] = _mm_set1_epi8(m_delims[d]);
+
+    for (; first + 16 <= last; first += 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+        __m128i match = _mm_cmpeq_epi8(chunk, eol);
+        for (size_t d = 0; d < m_numDelims; ++d) match = _mm_or_si128(match, _mm_cmpeq_epi8(chunk, delims[d]));
+        if (int mask = _mm_movemask_epi8(match); mask != 0) {
+            return first + __builtin_ctz(mask);
+        }
+    }
+#endif
+    for (; first != last; ++first) {
+        if (m_isSpecial[static_cast<unsigned char>(*first)]) return first;
+    }
+    return last;
+}
+
+// move the unfinished record [keepFrom, m_end) to the front then read more data after it
+void RecordReader::refill(size_t keepFrom)
+{
+    const size_t kept = m_end - keepFrom;
+    if (kept == m_buffer.size()) {
+        m_buffer.resize(m_buffer.size() * 2); // one record bigger than the buffer
+    }
+    std::memmove(m_buffer.data(), m_buffer.data() + keepFrom, kept);
+    m_in.read(m_buffer.data() + kept, m_buffer.size() - kept);
+    const auto got = static_cast<size_t>(m_in.gcount());
+    m_eof = got == 0;
+    m_pos = 0;
+    m_end = kept + got;
+}
+
+bool RecordReader::next(std::vector<std::string_view>& fields)
+{
+    fields.clear();
+    size_t fieldStart = m_pos;  // m_pos stays on the start of the record until it is complete
+    size_t scan = m_pos;
+    while (true) {
+        const char* data = m_buffer.data();
+        const char* found = findSpecial(data + scan, data + m_end);
+        if (found != data + m_end) {
+            const auto at = static_cast<size_t>(found - data);
+            fields.emplace_back(data + fieldStart, at - fieldStart);
+            fieldStart = scan = at + 1;
+            if (*found == m_eol) {
+                m_pos = scan;
+                return true;
+            }
+            continue;
+        }
+        if (m_eof) {
+            if (fields.empty() && fieldStart == m_end) return false;   // nothing left
+            fields.emplace_back(data + fieldStart, m_end - fieldStart); // last line without eol
+            m_pos = m_end;
+            return true;
+        }
+        // no end of line in the buffer: read more and rescan the record from its start
+        // (rescanning is cheaper than fixing up the views, records straddling 2 chunks are rare)
+        refill(m_pos);
+        fields.clear();
+        fieldStart = scan = 0;
+    }
+}
+
+
+// Benchmark
+
+void generateFile(const std::string& path, size_t megabytes)
+{
+    std::ofstream out{path, std::ios::binary};
+    std::string line;
+    unsigned seed = 42;
+    size_t written = 0;
+    while (written < megabytes * 1024 * 1024) {
+        seed = seed * 1103515245 + 12345;
+        line = std::to_string(seed % 100000) + ':' + std::to_string(seed % 997) + ",user" +
+               std::to_string(seed % 1234) + ",GET:/index.html," + std::to_string(seed % 512) + '\n';
+        out << line;
+        written += line.size();
+    }
+}
+
+struct Result {
+    size_t records = 0;
+    size_t fields = 0;
+    size_t bytes = 0;   // sum of the field sizes, to check both parsers agree
+};
+
+// what string.cpp does: getline then istringstream + getline per field (',' replaced by ':' to have one delimiter)
+Result parseGetline(const std::string& path)
+{
+    Result res;
+    std::ifstream in{path, std::ios::binary};
+    std::string line;
+    while (std::getline(in, line)) {
+        std::replace(line.begin(), line.end(), ',', ':');
+        std::istringstream strtosplit(line);
+        std::string field;
+        while (std::getline(strtosplit, field, ':')) {
+            ++res.fields;
+            res.bytes += field.size();
+        }
+        ++res.records;
+    }
+    return res;
+}
+
+Result parseRecordReader(const std::string& path)
+{
+    Result res;
+    std::ifstream in{path, std::ios::binary};
+    RecordReader reader{in, ":,"};
+    std::vector<std::string_view> fields;   // reused: no allocation once it has grown
+    while (reader.next(fields)) {
+        ++res.records;
+        res.fields += fields.size();
+        for (auto field : fields) res.bytes += field.size();
+    }
+    return res;
+}
+
+template<typename F>
+void benchmark(const char* name, const std::string& path, size_t megabytes, F&& parse)
+{
+    auto start = std::chrono::steady_clock::now();
+    auto res = parse(path);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << name << ": " << megabytes / elapsed.count() << " MB/s (" << res.records << " records, "
+              << res.fields << " fields, " << res.bytes << " bytes)\n";
+}
+
+int main(int argc, char* argv[])
+{
+    // 1. straddling records: a tiny chunk size forces records to cross chunk boundaries
+    std::istringstream text{"123:456\nab,cd:ef\nrecord longer than the chunk,x\nlast:line"};
+    RecordReader reader{text, ":,", '\n', 8};
+    std::vector<std::string_view> fields;
+    while (reader.next(fields)) {
+        for (auto field : fields) std::cout << "[" << field << "]";
+        std::cout << "\n";
+    }
+
+    // 2. throughput against getline + istringstream
+    const size_t megabytes = argc > 1 ? std::stoul(argv[1]) : 200;
+    const std::string path = "record_parser_bench.txt";
+    generateFile(path, megabytes);
+    benchmark("getline + istringstream", path, megabytes, parseGetline);
+    benchmark("RecordReader           ", path, megabytes, parseRecordReader);
+    std::remove(path.c_str());
+}
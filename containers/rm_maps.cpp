@@ -2,15 +2,17 @@
 #include <algorithm>
 #include <iostream>
 #include <experimental/map>
+#include "../common/out_sink.h"
 
 template <typename C>
 void disp(const C& cont) {
-
+    auto& out = output::stdoutSink();
     for (const auto& [key, val] : cont){
-        std::cout << key << " : ";
-        std::cout << val << "\n";
+        out << key << " : ";
+        out << val << "\n";
     }
-    std::cout << "\n";
+    out << "\n";
+    out.flush();
 }
 
 int main() {
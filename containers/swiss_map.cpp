@@ -0,0 +1,523 @@
+/*
+
+SwissMap: an open addressing hash map in the style of the "Swiss tables" (abseil flat_hash_map).
+std::unordered_map allocates one node per element and a lookup follows a pointer per element of the bucket.
+Here all the elements are in one array of slots, next to an array of control bytes, one per slot:
+ - empty (0x80), deleted (0xFE) or full: then the byte holds the 7 low bits of the hash (h2)
+ - the slots are probed by groups of 16: one SSE2 compare of h2 against the 16 control bytes gives
+   the candidates, so the key itself is compared only about once per lookup
+ - a lookup stops at the first group with an empty slot: a miss is as cheap as a hit
+
+Heterogeneous lookup: with a transparent hash and equality (StringHash and std::equal_to<>), find("John")
+or find(std::string_view) does not build a temporary std::string.
+Any insertion may rehash and invalidate the iterators and the references to the elements (unlike std::unordered_map).
+
+1) g++ -std=c++17 -O2 -Wall -pedantic swiss_map.cpp -o swiss_map
+2) ./swiss_map 10000000    // benchmark from 1K up to 10M entries (default 1M)
+
+*/
+
+#include "../common/bench.h"
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <utility>
+#include <stdexcept>
+#include <type_traits>
+#include <random>
+#include <cstdint>
+#include <cstring>
+#include <cassert>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+
+// 1. Control bytes and the group of 16 probed at once
+
+namespace ctrl {
+constexpr int8_t kEmpty = -128;    // 0x80
+constexpr int8_t kDeleted = -2;    // 0xFE
+constexpr size_t kGroupSize = 16;
+inline bool isFull(int8_t c) { return c >= 0; }
+}
+
+// bit i set if control byte i of the group matches
+struct Group {
+    explicit Group(const int8_t* pos) {
+#if defined(__SSE2__)
+        m_ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+#else
+        std::memcpy(m_ctrl, pos, ctrl::kGroupSize);
+#endif
+    }
+
+    uint32_t match(int8_t h2) const {
+#if defined(__SSE2__)
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(m_ctrl, _mm_set1_epi8(h2))));
+#else
+        uint32_t mask = 0;
+        for (size_t i = 0; i < ctrl::kGroupSize; ++i) mask |= uint32_t{m_ctrl[i] == h2} << i;
+        return mask;
+#endif
+    }
+
+    uint32_t matchEmpty() const { return match(ctrl::kEmpty); }
+
+    // empty or deleted: full bytes are >= 0, the sign bit is enough
+    uint32_t matchAvailable() const {
+#if defined(__SSE2__)
+        return static_cast<uint32_t>(_mm_movemask_epi8(m_ctrl));
+#else
+        uint32_t mask = 0;
+        for (size_t i = 0; i < ctrl::kGroupSize; ++i) mask |= uint32_t{m_ctrl[i] < 0} << i;
+        return mask;
+#endif
+    }
+
+ private:
+#if defined(__SSE2__)
+    __m128i m_ctrl;
+#else
+    int8_t m_ctrl[ctrl::kGroupSize];
+#endif
+};
+
+// hash for std::string, std::string_view and const char*: all the same hash, no conversion to std::string
+struct StringHash {
+    using is_transparent = void;
+    size_t operator()(std::string_view str) const { return std::hash<std::string_view>{}(str); }
+};
+
+
+// 2. The map
+
+template<typename Key, typename T, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+class SwissMap {
+ public:
+    using key_type = Key;
+    using mapped_type = T;
+    using value_type = std::pair<const Key, T>;
+    using size_type = size_t;
+
+    template<bool Const>
+    class Iterator {
+     public:
+        using map_type = std::conditional_t<Const, const SwissMap, SwissMap>;
+        using value_type = SwissMap::value_type;
+        using reference = std::conditional_t<Const, const value_type&, value_type&>;
+        using pointer = std::conditional_t<Const, const value_type*, value_type*>;
+        using difference_type = std::ptrdiff_t;
+        using iterator_category = std::forward_iterator_tag;
+
+        Iterator() = default;
+        Iterator(map_type* map, size_t pos):m_map{map},m_pos{pos} { skipEmpty(); }
+        operator Iterator<true>() const { return {m_map, m_pos}; }
+
+        reference operator*() const { return *m_map->slot(m_pos); }
+        pointer operator->() const { return m_map->slot(m_pos); }
+
+        Iterator& operator++() { ++m_pos; skipEmpty(); return *this; }
+        Iterator operator++(int) { auto tmp = *this; ++*this; return tmp; }
+
+        bool operator==(const Iterator& other) const { return m_pos == other.m_pos; }
+        bool operator!=(const Iterator& other) const { return m_pos != other.m_pos; }
+
+        size_t index() const { return m_pos; }
+
+     private:
+        void skipEmpty() {
+            while (m_pos < m_map->m_capacity && !ctrl::isFull(m_map->m_ctrl[m_pos])) ++m_pos;
+        }
+
+        map_type* m_map = nullptr;
+        size_t m_pos = 0;
+    };
+
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    SwissMap() = default;
+    explicit SwissMap(size_t expected) { reserve(expected); }
+    SwissMap(std::initializer_list<value_type> init) {
+        reserve(init.size());
+        for (const auto& value : init) insert(value);
+    }
+    SwissMap(const SwissMap& other) {
+        reserve(other.size());
+        for (const auto& value : other) insert(value);
+    }
+    SwissMap(SwissMap&& other) noexcept { swap(other); }
+    SwissMap& operator=(SwissMap other) noexcept { swap(other); return *this; }
+    ~SwissMap() { destroyAll(); }
+
+    void swap(SwissMap& other) noexcept {
+        std::swap(m_ctrl, other.m_ctrl);
+        std::swap(m_slots, other.m_slots);
+        std::swap(m_capacity, other.m_capacity);
+        std::swap(m_size, other.m_size);
+        std::swap(m_growthLeft, other.m_growthLeft);
+        std::swap(m_hash, other.m_hash);
+        std::swap(m_equal, other.m_equal);
+    }
+
+    iterator begin() { return {this, 0}; }
+    iterator end() { return {this, m_capacity}; }
+    const_iterator begin() const { return {this, 0}; }
+    const_iterator end() const { return {this, m_capacity}; }
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    size_t capacity() const { return m_capacity; }
+    float load_factor() const { return m_capacity == 0 ? 0.f : float(m_size) / m_capacity; }
+
+    void clear() { destroyAll(); }
+
+    // enough slots for n elements without rehash
+    void reserve(size_t n) {
+        size_t cap = ctrl::kGroupSize;
+        while (maxLoad(cap) < n) cap *= 2;
+        if (cap > m_capacity) rehash(cap);
+    }
+
+    iterator find(const Key& key) { return {this, findIndex(key)}; }
+    const_iterator find(const Key& key) const { return {this, findIndex(key)}; }
+    bool contains(const Key& key) const { return findIndex(key) != m_capacity; }
+    size_t count(const Key& key) const { return contains(key) ? 1 : 0; }
+
+    // heterogeneous lookup if both Hash and KeyEqual are transparent (like C++20 unordered_map)
+    template<typename K, typename H = Hash, typename E = KeyEqual,
+             typename = typename H::is_transparent, typename = typename E::is_transparent>
+    iterator find(const K& key) { return {this, findIndex(key)}; }
+    template<typename K, typename H = Hash, typename E = KeyEqual,
+             typename = typename H::is_transparent, typename = typename E::is_transparent>
+    const_iterator find(const K& key) const { return {this, findIndex(key)}; }
+    template<typename K, typename H = Hash, typename E = KeyEqual,
+             typename = typename H::is_transparent, typename = typename E::is_transparent>
+    bool contains(const K& key) const { return findIndex(key) != m_capacity; }
+
+    T& at(const Key& key) {
+        auto pos = findIndex(key);
+        if (pos == m_capacity) throw std::out_of_range{"SwissMap::at: key not found"};
+        return slot(pos)->second;
+    }
+    const T& at(const Key& key) const { return const_cast<SwissMap*>(this)->at(key); }
+
+    T& operator[](const Key& key) { return try_emplace(key).first->second; }
+    T& operator[](Key&& key) { return try_emplace(std::move(key)).first->second; }
+
+    std::pair<iterator, bool> insert(const value_type& value) { return try_emplace(value.first, value.second); }
+    template<typename P, typename = std::enable_if_t<std::is_constructible_v<value_type, P&&>>>
+    std::pair<iterator, bool> insert(P&& value) {
+        value_type tmp(std::forward<P>(value));
+        return try_emplace(std::move(const_cast<Key&>(tmp.first)), std::move(tmp.second));
+    }
+
+    // the arguments are untouched (not moved from) if the key already exists
+    template<typename... Args>
+    std::pair<iterator, bool> try_emplace(const Key& key, Args&&... args) { return tryEmplace(key, std::forward<Args>(args)...); }
+    template<typename... Args>
+    std::pair<iterator, bool> try_emplace(Key&& key, Args&&... args) { return tryEmplace(std::move(key), std::forward<Args>(args)...); }
+
+    template<typename M>
+    std::pair<iterator, bool> insert_or_assign(const Key& key, M&& obj) {
+        auto [iter, inserted] = try_emplace(key, std::forward<M>(obj));
+        if (!inserted) iter->second = std::forward<M>(obj);
+        return {iter, inserted};
+    }
+    template<typename M>
+    std::pair<iterator, bool> insert_or_assign(Key&& key, M&& obj) {
+        auto [iter, inserted] = try_emplace(std::move(key), std::forward<M>(obj));
+        if (!inserted) iter->second = std::forward<M>(obj);
+        return {iter, inserted};
+    }
+
+    size_t erase(const Key& key) {
+        auto pos = findIndex(key);
+        if (pos == m_capacity) return 0;
+        eraseAt(pos);
+        return 1;
+    }
+    // returns the next element, the other iterators stay valid (erase never rehashes)
+    iterator erase(const_iterator pos) {
+        eraseAt(pos.index());
+        return {this, pos.index() + 1};
+    }
+
+    template<typename Pred>
+    friend size_t erase_if(SwissMap& map, Pred pred) {
+        size_t removed = 0;
+        for (size_t i = 0; i < map.m_capacity; ++i) {
+            if (ctrl::isFull(map.m_ctrl[i]) && pred(std::as_const(*map.slot(i)))) {
+                map.eraseAt(i);
+                ++removed;
+            }
+        }
+        return removed;
+    }
+
+ private:
+    // 7/8 max load factor: a group always has room before the table is full
+    static size_t maxLoad(size_t capacity) { return capacity - capacity / 8; }
+
+    // std::hash of an integer is the identity: mix the bits so h1 and h2 both get some entropy
+    template<typename K>
+    size_t hashOf(const K& key) const {
+        const uint64_t h = static_cast<uint64_t>(m_hash(key)) * 0x9E3779B97F4A7C15ULL;
+        return static_cast<size_t>(h ^ (h >> 32));
+    }
+    static int8_t h2(size_t hash) { return static_cast<int8_t>(hash & 0x7F); }
+
+    // triangular probing over the groups: visits every group once when their number is a power of 2
+    size_t firstGroup(size_t hash) const { return (hash >> 7) & (m_capacity / ctrl::kGroupSize - 1); }
+    size_t nextGroup(size_t group, size_t step) const { return (group + step) & (m_capacity / ctrl::kGroupSize - 1); }
+
+    value_type* slot(size_t pos) { return std::launder(reinterpret_cast<value_type*>(m_slots.get()) + pos); }
+    const value_type* slot(size_t pos) const { return std::launder(reinterpret_cast<const value_type*>(m_slots.get()) + pos); }
+
+    template<typename K>
+    size_t findIndex(const K& key) const;
+
+    // first empty or deleted slot of the probe sequence of hash
+    size_t findAvailable(size_t hash) const;
+
+    template<typename K, typename... Args>
+    std::pair<iterator, bool> tryEmplace(K&& key, Args&&... args);
+
+    void eraseAt(size_t pos);
+    void rehash(size_t newCapacity);
+    void destroyAll();
+
+    using Storage = std::aligned_storage_t<sizeof(value_type), alignof(value_type)>;
+
+    std::unique_ptr<int8_t[]> m_ctrl;
+    std::unique_ptr<Storage[]> m_slots;   // raw memory: only the full slots hold an object
+    size_t m_capacity = 0;                // multiple of the group size, power of 2
+    size_t m_size = 0;
+    size_t m_growthLeft = 0;              // empty slots still usable before a rehash (deleted ones do not count)
+    Hash m_hash;
+    KeyEqual m_equal;
+};
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+template<typename K>
+size_t SwissMap<Key, T, Hash, KeyEqual>::findIndex(const K& key) const
+{
+    if (m_capacity == 0) return 0;
+    const size_t hash = hashOf(key);
+    size_t group = firstGroup(hash);
+    for (size_t step = 1; ; ++step) {
+        const size_t base = group * ctrl::kGroupSize;
+        const Group g{m_ctrl.get() + base};
+        for (uint32_t mask = g.match(h2(hash)); mask != 0; mask &= mask - 1) {
+            const size_t pos = base + __builtin_ctz(mask);
+            if (m_equal(slot(pos)->first, key)) return pos;
+        }
+        if (g.matchEmpty() != 0) return m_capacity;     // the key would have been inserted here
+        group = nextGroup(group, step);
+    }
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+size_t SwissMap<Key, T, Hash, KeyEqual>::findAvailable(size_t hash) const
+{
+    size_t group = firstGroup(hash);
+    for (size_t step = 1; ; ++step) {
+        const size_t base = group * ctrl::kGroupSize;
+        if (uint32_t mask = Group{m_ctrl.get() + base}.matchAvailable(); mask != 0) {
+            return base + __builtin_ctz(mask);
+        }
+        group = nextGroup(group, step);
+    }
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+template<typename K, typename... Args>
+std::pair<typename SwissMap<Key, T, Hash, KeyEqual>::iterator, bool> SwissMap<Key, T, Hash, KeyEqual>::tryEmplace(K&& key, Args&&... args)
+{
+    if (auto pos = findIndex(key); pos != m_capacity) return {iterator{this, pos}, false};
+
+    const size_t hash = hashOf(key);
+    size_t pos = m_capacity == 0 ? 0 : findAvailable(hash);
+    if (m_capacity == 0 || (m_growthLeft == 0 && m_ctrl[pos] == ctrl::kEmpty)) {
+        // full of elements: grow. Full of tombstones: rehash at the same size to clean them
+        rehash(m_size + 1 > maxLoad(m_capacity) / 2 ? std::max(m_capacity * 2, ctrl::kGroupSize) : m_capacity);
+        pos = findAvailable(hash);
+    }
+    new (slot(pos)) value_type(std::piecewise_construct, std::forward_as_tuple(std::forward<K>(key)),
+                               std::forward_as_tuple(std::forward<Args>(args)...));
+    if (m_ctrl[pos] == ctrl::kEmpty) --m_growthLeft;    // a deleted slot is reused for free
+    m_ctrl[pos] = h2(hash);
+    ++m_size;
+    return {iterator{this, pos}, true};
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+void SwissMap<Key, T, Hash, KeyEqual>::eraseAt(size_t pos)
+{
+    slot(pos)->~value_type();
+    --m_size;
+    // a lookup goes past a group only if it has no empty slot: if this group already has one,
+    // no probe sequence goes through it and the slot can be empty again, otherwise leave a tombstone
+    const size_t base = pos & ~(ctrl::kGroupSize - 1);
+    if (Group{m_ctrl.get() + base}.matchEmpty() != 0) {
+        m_ctrl[pos] = ctrl::kEmpty;
+        ++m_growthLeft;
+    }
+    else {
+        m_ctrl[pos] = ctrl::kDeleted;
+    }
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+void SwissMap<Key, T, Hash, KeyEqual>::rehash(size_t newCapacity)
+{
+    SwissMap fresh;
+    fresh.m_hash = m_hash;
+    fresh.m_equal = m_equal;
+    fresh.m_ctrl.reset(new int8_t[newCapacity]);
+    std::memset(fresh.m_ctrl.get(), ctrl::kEmpty, newCapacity);
+    fresh.m_slots.reset(new Storage[newCapacity]);
+    fresh.m_capacity = newCapacity;
+    fresh.m_growthLeft = maxLoad(newCapacity);
+
+    for (size_t i = 0; i < m_capacity; ++i) {
+        if (!ctrl::isFull(m_ctrl[i])) continue;
+        auto* old = slot(i);
+        const size_t hash = hashOf(old->first);
+        const size_t pos = fresh.findAvailable(hash);
+        // the key is const in value_type but the old slot is destroyed right after: moving from it is safe
+        new (fresh.slot(pos)) value_type(std::move(const_cast<Key&>(old->first)), std::move(old->second));
+        fresh.m_ctrl[pos] = h2(hash);
+        --fresh.m_growthLeft;
+        ++fresh.m_size;
+    }
+    swap(fresh);    // fresh now owns the old arrays and destroys the moved from elements
+}
+
+template<typename Key, typename T, typename Hash, typename KeyEqual>
+void SwissMap<Key, T, Hash, KeyEqual>::destroyAll()
+{
+    for (size_t i = 0; i < m_capacity; ++i) {
+        if (ctrl::isFull(m_ctrl[i])) slot(i)->~value_type();
+        m_ctrl[i] = ctrl::kEmpty;
+    }
+    m_size = 0;
+    m_growthLeft = maxLoad(m_capacity);
+}
+
+
+template <typename M>
+void disp(const M& container){
+    std::cout << "{ ";
+    for (const auto& [key,value] : container) {
+        std::cout << key << " : " << value << ", ";
+    }
+    std::cout << "}\n";
+}
+
+
+// 3. Benchmark: ns per operation, string keys
+
+struct Workload {
+    std::vector<std::string> keys;
+    std::vector<std::string> absent;
+    std::vector<std::string_view> hits;      // e.g. fields of a parsed file
+    std::vector<std::string_view> misses;
+};
+
+Workload makeWorkload(size_t n)
+{
+    Workload w;
+    std::mt19937_64 gen{42};
+    for (size_t i = 0; i < n; ++i) w.keys.push_back("player_" + std::to_string(gen()));
+    for (size_t i = 0; i < n; ++i) w.absent.push_back("missing_" + std::to_string(gen()));
+    const size_t queries = std::min<size_t>(n, 1'000'000);
+    for (size_t i = 0; i < queries; ++i) {
+        w.hits.push_back(w.keys[gen() % n]);
+        w.misses.push_back(w.absent[gen() % n]);
+    }
+    return w;
+}
+
+// the same workloads for every map type: lookups from std::string_view, as the std maps need a
+// std::string (C++17 has no heterogeneous lookup for unordered_map) they pay the conversion
+template<typename Map>
+std::vector<double> run(const Workload& w)
+{
+    auto lookup = [](const Map& map, std::string_view key) {
+        if constexpr (std::is_same_v<Map, SwissMap<std::string, int, StringHash, std::equal_to<>>>) return map.find(key) != map.end();
+        else return map.find(std::string{key}) != map.end();
+    };
+    Map map;
+    const size_t n = w.keys.size();
+    std::vector<double> ns;
+    ns.push_back(bench::nsPerOp(n, [&] { for (size_t i = 0; i < n; ++i) map.try_emplace(w.keys[i], int(i)); }));
+    size_t found = 0;
+    ns.push_back(bench::nsPerOp(w.hits.size(), [&] { for (auto key : w.hits) found += lookup(map, key); }));
+    ns.push_back(bench::nsPerOp(w.misses.size(), [&] { for (auto key : w.misses) found += lookup(map, key); }));
+    // erase heavy: remove then put back every key, tombstones and free slots churn
+    ns.push_back(bench::nsPerOp(2 * n, [&] {
+        for (size_t i = 0; i < n; ++i) {
+            map.erase(w.keys[i]);
+            if (i >= 16) map.try_emplace(w.keys[i - 16], int(i));
+        }
+        for (size_t i = n > 16 ? n - 16 : 0; i < n; ++i) map.try_emplace(w.keys[i], int(i));
+    }));
+    assert(found == w.hits.size() && map.size() == n);
+    bench::keep(found);
+    return ns;
+}
+
+void benchmark(size_t n)
+{
+    const auto w = makeWorkload(n);
+    using Swiss = SwissMap<std::string, int, StringHash, std::equal_to<>>;
+    const auto map = run<std::map<std::string, int>>(w);
+    const auto unordered = run<std::unordered_map<std::string, int>>(w);
+    const auto swiss = run<Swiss>(w);
+    const char* names[] = {"insert", "hit", "miss", "erase+insert"};
+    for (size_t i = 0; i < 4; ++i) {
+        std::cout << std::setw(10) << n << std::setw(14) << names[i] << std::setw(11) << map[i]
+                  << std::setw(11) << unordered[i] << std::setw(11) << swiss[i] << "\n";
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    // 1. same usage as add_maps.cpp
+    SwissMap<std::string, int, StringHash, std::equal_to<>> phone_book { {"John", 124}, {"Mary", 345}, {"Marc", 345}, };
+    phone_book["Leon"] = 4;
+    phone_book["Leon"] += 2;
+    phone_book.insert(std::pair{"Marc", 6});                // do not overwrite
+    phone_book.try_emplace("Ben", 47);
+    phone_book.try_emplace("Ben", 8);                       // do not overwrite
+    auto [it, insert] = phone_book.insert_or_assign("Ben", 4864654);
+    assert(insert == false && it->second == 4864654);
+    erase_if(phone_book, [](const auto& item) { return item.second == 345; });
+    disp(phone_book);                                        // no order, like std::unordered_map
+
+    // 2. displayNationality of iterate.cpp: string_view lookup, no std::string created
+    const SwissMap<std::string, std::string, StringHash, std::equal_to<>> playersNation {{"Djokovic","Serbian"},{"Nadal","Spanish"}};
+    for (std::string_view player : {"Federer", "Djokovic", "Nadal"}) {
+        auto nationality = playersNation.find(player);
+        std::cout << " " << player << " is " << (nationality != playersNation.end() ? nationality->second : "Swiss") << "\n";
+    }
+
+    // 3. benchmark
+    const size_t maxSize = argc > 1 ? std::stoul(argv[1]) : 1'000'000;
+    std::cout << "\n      size      workload   std::map  unordered  SwissMap   (ns/op)\n";
+    for (size_t n = 1000; n <= maxSize; n *= 10) {
+        benchmark(n);
+    }
+}
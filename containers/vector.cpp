@@ -4,16 +4,19 @@
 #include <algorithm>
 #include <experimental/vector>
 #include <functional>
+#include "../common/out_sink.h"
 
 
 template <typename T>
 void print(std::vector<T> & vecnum)
 {
-    std::cout << "vec: { ";
+    auto& out = output::stdoutSink();
+    out << "vec: { ";
     for (const auto & val : vecnum) {
-        std::cout << val << ", ";
+        out << val << ", ";
     }
-    std::cout << "} \n";
+    out << "} \n";
+    out.flush();
 }
 
 int main() {
@@ -81,7 +84,7 @@ int main() {
     print(v2);
     
     auto pred = [](auto const &elem){ return elem % 2 == 0;};
-    vector<int> v4;
+    vector<int> v4; // each step materializes a full vector: std_algo/pipeline.h fuses filter / transform in one loop
     copy_if(v1.begin(), v1.end(), back_inserter(v4), pred);
     print(v4);
     
@@ -116,7 +119,7 @@ int main() {
         cout << "found 10 \n";
     } 
 
-    // 8. vector of vector
+    // 8. vector of vector (one allocation per row: see matrix.cpp for a contiguous 2D array)
     vector<vector<int>> v3 = {{1, 2, 3}, {4 ,5 ,6}};
     cout << v3[1][1]; // row colum access 2d vec
 
@@ -3,20 +3,16 @@
 #include <vector>
 #include <algorithm> // for_each
 #include <set>
-#include <unordered_map>
+#include <string_view>
 
-void displayNationality(const std::string &player) {
+#include "lookup_table.h"
 
-    const std::unordered_map< std::string, std::string > playersNation {{"Djokovic","Serbian"},{"Nadal","Spanish"}};
+// the table is built once by the compiler (perfect hash, read only data), not at every call
+constexpr auto playersNation = lookup::makeStaticTable<std::string_view>({{"Djokovic","Serbian"},{"Nadal","Spanish"}});
 
-    std::cout << " " + (player) << " is ";
-    auto nationality = playersNation.find(player);
-    if (nationality != playersNation.end() ) {
-        std::cout << nationality->second << std::endl;
-    }
-    else {
-        std::cout << "Swiss" << std::endl;
-    }
+void displayNationality(std::string_view player) {
+
+    std::cout << " " << player << " is " << playersNation.valueOr(player, "Swiss") << std::endl;
 }
 
 template<typename C, typename V>
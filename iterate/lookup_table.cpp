@@ -0,0 +1,93 @@
+/*
+
+displayNationality of iterate.cpp built its std::unordered_map at every call: for_each over the players
+allocated and hashed the whole table once per player. Lookup cost per player, without the printing:
+ - per call: the original code
+ - static unordered_map: built once, still a std::string per lookup from a std::string_view
+ - StaticTable: perfect hash built at compile time
+ - LookupTable: same perfect hash built at runtime (e.g. a table loaded from a file at startup)
+
+1) g++ -std=c++17 -O2 -Wall -pedantic lookup_table.cpp -o lookup_table
+2) ./lookup_table 100000000    // from 10K up to 100M calls (default 10M)
+
+*/
+
+#include "lookup_table.h"
+#include "../common/bench.h"
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <chrono>
+#include <cassert>
+
+constexpr auto kPlayersNation = lookup::makeStaticTable<std::string_view>({{"Djokovic", "Serbian"}, {"Nadal", "Spanish"}});
+static_assert(kPlayersNation.valueOr("Nadal", "Swiss") == "Spanish", "looked up at compile time");
+static_assert(kPlayersNation.valueOr("Federer", "Swiss") == "Swiss", "looked up at compile time");
+
+// the table dies at the end of the call: the nationality is copied out (short string, no allocation)
+std::string nationalityPerCall(std::string_view player)
+{
+    const std::unordered_map< std::string, std::string > playersNation {{"Djokovic","Serbian"},{"Nadal","Spanish"}};
+    auto nationality = playersNation.find(std::string{player});
+    return nationality != playersNation.end() ? nationality->second : "Swiss";
+}
+
+std::string_view nationalityStaticMap(std::string_view player)
+{
+    static const std::unordered_map< std::string, std::string > playersNation {{"Djokovic","Serbian"},{"Nadal","Spanish"}};
+    auto nationality = playersNation.find(std::string{player});
+    return nationality != playersNation.end() ? std::string_view{nationality->second} : "Swiss";
+}
+
+std::string_view nationalityStaticTable(std::string_view player)
+{
+    return kPlayersNation.valueOr(player, "Swiss");
+}
+
+std::string_view nationalityLookupTable(std::string_view player)
+{
+    static const lookup::LookupTable<std::string_view> playersNation {{"Djokovic", "Serbian"}, {"Nadal", "Spanish"}};
+    return playersNation.valueOr(player, "Swiss");
+}
+
+template<typename F>
+double nsPerCall(const std::vector<std::string>& players, size_t calls, F&& nationality)
+{
+    size_t total = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < calls; ++i) {
+        total += nationality(players[i % players.size()]).size();
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    bench::keep(total);
+    return elapsed.count() / calls;
+}
+
+int main(int argc, char* argv[])
+{
+    // 1. a runtime table of 100K entries loaded at startup: every key found, no other key matches
+    std::vector<std::string> names;
+    std::vector<std::pair<std::string_view, int>> entries;
+    for (int i = 0; i < 100'000; ++i) names.push_back("player_" + std::to_string(i));
+    for (int i = 0; i < 100'000; ++i) entries.emplace_back(names[i], i);
+    const lookup::LookupTable<int> ranking{entries};
+    for (int i = 0; i < 100'000; ++i) assert(*ranking.find(names[i]) == i);
+    assert(!ranking.contains("player_100000") && !ranking.contains(""));
+    std::cout << "LookupTable of " << ranking.size() << " players: " << *ranking.find("player_4242") << "\n\n";
+
+    // 2. nationality of the players of iterate.cpp, ns per call
+    const std::vector<std::string> players {"Federer", "Djokovic", "Nadal"};
+    const size_t maxCalls = argc > 1 ? std::stoul(argv[1]) : 10'000'000;
+    std::cout << "     calls   per call  static map  StaticTable  LookupTable   (ns/call)\n";
+    for (size_t calls = 10'000; calls <= maxCalls; calls *= 10) {
+        std::cout << std::setw(10) << calls
+                  << std::setw(11) << nsPerCall(players, calls, nationalityPerCall)
+                  << std::setw(12) << nsPerCall(players, calls, nationalityStaticMap)
+                  << std::setw(13) << nsPerCall(players, calls, nationalityStaticTable)
+                  << std::setw(13) << nsPerCall(players, calls, nationalityLookupTable) << "\n";
+    }
+}
@@ -0,0 +1,229 @@
+/*
+
+Immutable string keyed lookup tables built once, looked up by std::string_view.
+
+Both use a perfect hash ("hash and displace"): the keys are spread in buckets by their hash, then for each bucket,
+biggest first, a seed is searched so that all its keys land in free slots. A lookup is then one hash of the key,
+one read of the bucket seed, one slot and one key comparison: no probing, no collision, no allocation.
+ - StaticTable: built by the compiler from a constexpr list, the whole table ends up in read only data
+ - LookupTable: same algorithm at runtime for tables loaded at startup, the keys are stored in one single buffer
+
+    constexpr auto playersNation = makeStaticTable<std::string_view>({{"Djokovic", "Serbian"}, {"Nadal", "Spanish"}});
+    playersNation.valueOr(player, "Swiss");
+
+Keys must be unique (a duplicate is a compile error for StaticTable, an exception for LookupTable).
+
+C++17
+
+*/
+
+#ifndef LOOKUP_TABLE_H
+#define LOOKUP_TABLE_H
+
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace lookup {
+
+// FNV-1a, usable at compile time
+constexpr uint64_t hashKey(std::string_view key)
+{
+    uint64_t h = 14695981039346656037ULL;
+    for (char c : key) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+// slot of a key given its hash and the seed of its bucket (numSlots is a power of 2)
+constexpr size_t slotOf(uint64_t hash, uint32_t seed, size_t numSlots)
+{
+    uint64_t h = hash ^ (seed * 0x9E3779B97F4A7C15ULL);
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    return static_cast<size_t>(h) & (numSlots - 1);
+}
+
+constexpr size_t nextPow2(size_t n)
+{
+    size_t p = 1;
+    while (p < n) p *= 2;
+    return p;
+}
+
+// Fills seeds (numBuckets) and slots (numSlots, entry index + 1, 0 when free) for the n keys.
+// hashes, order (n) and starts (numBuckets + 1) are scratch arrays: std::array at compile time, std::vector at runtime
+template<typename Keys, typename Seeds, typename Slots, typename Hashes, typename Order, typename Starts>
+constexpr void buildPerfectHash(const Keys& keys, size_t n, Seeds& seeds, size_t numBuckets, Slots& slots, size_t numSlots,
+                                Hashes& hashes, Order& order, Starts& starts)
+{
+    // 1. bucket of each key, entries sorted by bucket (counting sort)
+    for (size_t b = 0; b <= numBuckets; ++b) starts[b] = 0;
+    for (size_t i = 0; i < n; ++i) {
+        hashes[i] = hashKey(keys[i]);
+        ++starts[(hashes[i] & (numBuckets - 1)) + 1];
+    }
+    size_t biggest = 0;
+    for (size_t b = 0; b < numBuckets; ++b) {
+        biggest = starts[b + 1] > biggest ? starts[b + 1] : biggest;
+        starts[b + 1] += starts[b];
+    }
+    for (size_t i = 0; i < n; ++i) {
+        const size_t b = hashes[i] & (numBuckets - 1);
+        order[starts[b]++] = i;         // starts[b] becomes the end of bucket b...
+    }
+    for (size_t b = numBuckets; b > 0; --b) starts[b] = starts[b - 1];
+    starts[0] = 0;                      // ...shift back: bucket b is [starts[b], starts[b + 1])
+
+    // 2. the biggest buckets first, while most slots are still free
+    for (size_t b = 0; b < numBuckets; ++b) seeds[b] = 0;
+    for (size_t i = 0; i < numSlots; ++i) slots[i] = 0;
+    for (size_t size = biggest; size > 0; --size) {
+        for (size_t b = 0; b < numBuckets; ++b) {
+            if (starts[b + 1] - starts[b] != size) continue;
+            for (uint32_t seed = 1; ; ++seed) {
+                if (seed == (1u << 20)) throw std::logic_error{"lookup table: duplicate keys"};
+                bool free = true;
+                for (size_t i = starts[b]; i < starts[b + 1] && free; ++i) {
+                    const size_t slot = slotOf(hashes[order[i]], seed, numSlots);
+                    free = slots[slot] == 0;
+                    for (size_t j = starts[b]; j < i && free; ++j) {    // 2 keys of the bucket on the same slot
+                        free = slot != slotOf(hashes[order[j]], seed, numSlots);
+                    }
+                }
+                if (!free) continue;
+                seeds[b] = seed;
+                for (size_t i = starts[b]; i < starts[b + 1]; ++i) {
+                    slots[slotOf(hashes[order[i]], seed, numSlots)] = static_cast<uint32_t>(order[i] + 1);
+                }
+                break;
+            }
+        }
+    }
+}
+
+
+// 1. Compile time table
+
+template<typename V, size_t N>
+class StaticTable {
+ public:
+    static constexpr size_t kBuckets = nextPow2(N);
+    static constexpr size_t kSlots = 2 * kBuckets;  // half empty: a seed is found after a few tries
+
+    constexpr explicit StaticTable(const std::pair<std::string_view, V> (&entries)[N]) {
+        std::array<std::string_view, N> keys{};
+        for (size_t i = 0; i < N; ++i) {
+            keys[i] = entries[i].first;
+            m_keys[i] = entries[i].first;
+            m_values[i] = entries[i].second;
+        }
+        std::array<uint64_t, N> hashes{};
+        std::array<size_t, N> order{};
+        std::array<size_t, kBuckets + 1> starts{};
+        buildPerfectHash(keys, N, m_seeds, kBuckets, m_slots, kSlots, hashes, order, starts);
+    }
+
+    // nullptr if the key is not in the table
+    constexpr const V* find(std::string_view key) const {
+        const uint64_t hash = hashKey(key);
+        const uint32_t index = m_slots[slotOf(hash, m_seeds[hash & (kBuckets - 1)], kSlots)];
+        return index != 0 && m_keys[index - 1] == key ? &m_values[index - 1] : nullptr;
+    }
+
+    constexpr V valueOr(std::string_view key, V fallback) const {
+        const V* value = find(key);
+        return value != nullptr ? *value : fallback;
+    }
+
+    constexpr bool contains(std::string_view key) const { return find(key) != nullptr; }
+    constexpr size_t size() const { return N; }
+
+ private:
+    std::array<std::string_view, N> m_keys{};
+    std::array<V, N> m_values{};
+    std::array<uint32_t, kBuckets> m_seeds{};
+    std::array<uint32_t, kSlots> m_slots{};
+};
+
+// V must be a literal type (std::string_view, int, enum...) as the table is built at compile time
+template<typename V, size_t N>
+constexpr StaticTable<V, N> makeStaticTable(const std::pair<std::string_view, V> (&entries)[N])
+{
+    return StaticTable<V, N>{entries};
+}
+
+
+// 2. Runtime table
+
+template<typename V>
+class LookupTable {
+ public:
+    LookupTable() = default;
+
+    LookupTable(std::initializer_list<std::pair<std::string_view, V>> entries)
+    :LookupTable(std::vector<std::pair<std::string_view, V>>(entries)) {}
+
+    // the keys are copied in the table: entries can be views on a temporary buffer (e.g. a file being parsed)
+    explicit LookupTable(const std::vector<std::pair<std::string_view, V>>& entries) {
+        size_t total = 0;
+        for (const auto& entry : entries) total += entry.first.size();
+        m_pool.reserve(total);
+        m_keys.reserve(entries.size());
+        m_values.reserve(entries.size());
+        for (const auto& entry : entries) {
+            m_keys.emplace_back(m_pool.size(), entry.first.size());
+            m_pool.append(entry.first);
+            m_values.push_back(entry.second);
+        }
+
+        const size_t n = entries.size();
+        m_numBuckets = nextPow2(n);
+        m_numSlots = 2 * m_numBuckets;
+        m_seeds.resize(m_numBuckets);
+        m_slots.resize(m_numSlots);
+        std::vector<std::string_view> keys(n);
+        for (size_t i = 0; i < n; ++i) keys[i] = key(i);
+        std::vector<uint64_t> hashes(n);
+        std::vector<size_t> order(n);
+        std::vector<size_t> starts(m_numBuckets + 1);
+        buildPerfectHash(keys, n, m_seeds, m_numBuckets, m_slots, m_numSlots, hashes, order, starts);
+    }
+
+    const V* find(std::string_view key) const {
+        if (m_keys.empty()) return nullptr;
+        const uint64_t hash = hashKey(key);
+        const uint32_t index = m_slots[slotOf(hash, m_seeds[hash & (m_numBuckets - 1)], m_numSlots)];
+        return index != 0 && this->key(index - 1) == key ? &m_values[index - 1] : nullptr;
+    }
+
+    V valueOr(std::string_view key, V fallback) const {
+        const V* value = find(key);
+        return value != nullptr ? *value : fallback;
+    }
+
+    bool contains(std::string_view key) const { return find(key) != nullptr; }
+    size_t size() const { return m_keys.size(); }
+
+ private:
+    std::string_view key(size_t i) const { return std::string_view{m_pool}.substr(m_keys[i].first, m_keys[i].second); }
+
+    std::string m_pool;                                  // all the keys back to back
+    std::vector<std::pair<size_t, size_t>> m_keys;       // offset, length in m_pool
+    std::vector<V> m_values;
+    std::vector<uint32_t> m_seeds;
+    std::vector<uint32_t> m_slots;
+    size_t m_numBuckets = 0;
+    size_t m_numSlots = 0;
+};
+
+} // namespace lookup
+
+#endif // LOOKUP_TABLE_H
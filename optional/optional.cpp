@@ -5,7 +5,10 @@
 #include <utility>
 #include <algorithm>
 #include <ctype.h>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <charconv>
 
 std::optional<std::vector<int>::const_iterator> findElem(const std::vector<int> vec, int target) {
     // copy elision is mandatory in C++17 it's more optimal to use - not named optional - if possible -> not temp. created
@@ -16,11 +19,17 @@ std::optional<std::vector<int>::const_iterator> findElem(const std::vector<int>
     return std::nullopt; 
 }
 
-std::optional<int> newFct(const std::string& str_dec) {
-    if (isdigit(str_dec[0])) {
-        return std::stoi (str_dec, nullptr, 10);
+std::optional<int> newFct(std::string_view str_dec) {
+    // from_chars does not need a std::string and never allocates (see parse_number.cpp).
+    // Same results as isdigit + stoi: a leading digit is required ("-5" gives nullopt), an overflow throws
+    if (str_dec.empty() || !isdigit(static_cast<unsigned char>(str_dec[0]))) {
+        return std::nullopt;
     }
-    return std::nullopt;
+    int value = 0;
+    if (auto [end, ec] = std::from_chars(str_dec.data(), str_dec.data() + str_dec.size(), value); ec == std::errc::result_out_of_range) {
+        throw std::out_of_range{"newFct: " + std::string{str_dec}};
+    }
+    return value;
 }
 
 int legacyFct(const std::string& str_dec) {
@@ -0,0 +1,217 @@
+/*
+
+Allocation free number parsing from std::string_view.
+ - std::stoi needs a std::string and throws on overflow or when there is no number
+ - std::from_chars (C++17) works on any char range, never allocates, never throws and reports errors with std::errc
+
+On top of from_chars, integers use a fast path: up to 16 digits are copied right aligned in a 16 bytes block filled with '0',
+validated all at once with SSE2 then converted 8 digits at a time with a few multiplications (SWAR: SIMD Within A Register).
+parseColumn() converts a whole column of fields (e.g. given by a record parser).
+
+1) g++ -std=c++17 -O2 -Wall -pedantic parse_number.cpp -o parse_number
+
+*/
+
+#include "../common/bench.h"
+
+#include <iostream>
+#include <iomanip>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <charconv>
+#include <system_error>
+#include <limits>
+#include <cstdint>
+#include <cstring>
+#include <chrono>
+#include <type_traits>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+
+// 1. Digits validation and conversion, 8 or 16 at once
+
+// true if the 16 chars are all '0'..'9'
+bool allDigits16(const char* chars)
+{
+#if defined(__SSE2__)
+    const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(chars));
+    // c - '0' as unsigned must be <= 9: shift the range to signed and compare ('0'..'9' -> -128..-119)
+    const __m128i shifted = _mm_sub_epi8(block, _mm_set1_epi8(static_cast<char>('0' + 128)));
+    const __m128i bad = _mm_cmpgt_epi8(shifted, _mm_set1_epi8(-128 + 9));
+    return _mm_movemask_epi8(bad) == 0;
+#else
+    uint64_t lo, hi;
+    std::memcpy(&lo, chars, 8);
+    std::memcpy(&hi, chars + 8, 8);
+    auto digits8 = [](uint64_t v) {
+        return (((v & 0xF0F0F0F0F0F0F0F0) | (((v + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4)) == 0x3333333333333333);
+    };
+    return digits8(lo) && digits8(hi);
+#endif
+}
+
+// 8 ASCII digits (already validated) to their value, little endian
+uint32_t parse8Digits(const char* chars)
+{
+    uint64_t val;
+    std::memcpy(&val, chars, 8);
+    val = (val & 0x0F0F0F0F0F0F0F0F) * 2561 >> 8;                 // pairs of digits
+    val = (val & 0x00FF00FF00FF00FF) * 6553601 >> 16;             // groups of 4
+    return static_cast<uint32_t>((val & 0x0000FFFF0000FFFF) * 42949672960001 >> 32);
+}
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+constexpr bool kFastPath = true;
+#else
+constexpr bool kFastPath = false; // parse8Digits assumes little endian
+#endif
+
+
+// 2. Parse one number: std::errc{} on success, like std::from_chars the whole field must be a number
+
+template<typename T>
+std::errc parseNumber(std::string_view str, T& value)
+{
+    static_assert(std::is_arithmetic_v<T>, "parseNumber: arithmetic type required");
+    if constexpr (std::is_integral_v<T> && sizeof(T) <= 8) {
+        const bool negative = std::is_signed_v<T> && !str.empty() && str.front() == '-';
+        const auto digits = str.substr(negative ? 1 : 0);
+        if (kFastPath && !digits.empty() && digits.size() <= 16) {
+            char block[16];
+            std::memset(block, '0', 16);
+            std::memcpy(block + 16 - digits.size(), digits.data(), digits.size());
+            if (!allDigits16(block)) return std::errc::invalid_argument;
+            const uint64_t magnitude = uint64_t{parse8Digits(block)} * 100'000'000 + parse8Digits(block + 8);
+            const uint64_t limit = negative ? uint64_t(std::numeric_limits<T>::max()) + 1 : uint64_t(std::numeric_limits<T>::max());
+            if (magnitude > limit) return std::errc::result_out_of_range;
+            value = negative ? static_cast<T>(0 - magnitude) : static_cast<T>(magnitude);
+            return std::errc{};
+        }
+    }
+    // more than 16 digits, floating point: from_chars does the job
+    auto [end, ec] = std::from_chars(str.data(), str.data() + str.size(), value);
+    if (ec == std::errc{} && end != str.data() + str.size()) return std::errc::invalid_argument; // "12abc"
+    return ec;
+}
+
+template<typename T>
+std::optional<T> parseNumber(std::string_view str)
+{
+    T value;
+    if (parseNumber(str, value) == std::errc{}) return value;
+    return std::nullopt;
+}
+
+
+// 3. Batch: convert a column of fields. values[i] is 0 for an invalid field and its index is added to invalid.
+// Returns the number of fields converted
+
+template<typename T>
+size_t parseColumn(const std::vector<std::string_view>& fields, std::vector<T>& values, std::vector<size_t>& invalid)
+{
+    values.resize(fields.size());
+    invalid.clear();
+    for (size_t i = 0; i < fields.size(); ++i) {
+        if (parseNumber(fields[i], values[i]) != std::errc{}) {
+            values[i] = 0;
+            invalid.push_back(i);
+        }
+    }
+    return fields.size() - invalid.size();
+}
+
+
+// 4. Benchmark: ns per number
+
+std::vector<std::string> makeNumbers(size_t count, bool floating)
+{
+    std::vector<std::string> numbers;
+    numbers.reserve(count);
+    uint64_t seed = 7;
+    for (size_t i = 0; i < count; ++i) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        auto n = static_cast<int64_t>(seed >> (33 + seed % 24)) * ((seed & 1) ? -1 : 1);
+        numbers.push_back(floating ? std::to_string(n / 1000.0) : std::to_string(n));
+    }
+    return numbers;
+}
+
+template<typename F>
+double nsPerNumber(size_t count, F&& f)
+{
+    auto start = std::chrono::steady_clock::now();
+    auto check = f();
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    bench::keep(static_cast<double>(check));
+    return elapsed.count() / count;
+}
+
+template<typename T, typename Std>
+void benchmark(const char* type, const std::vector<std::string>& numbers, Std&& stdConvert)
+{
+    const std::vector<std::string_view> fields(numbers.begin(), numbers.end());
+    std::vector<T> values;
+    std::vector<size_t> invalid;
+
+    auto stdNs = nsPerNumber(numbers.size(), [&] {
+        double total = 0;
+        for (const auto& s : numbers) total += stdConvert(s);
+        return total;
+    });
+    auto fromCharsNs = nsPerNumber(numbers.size(), [&] {
+        double total = 0;
+        for (auto field : fields) {
+            T value{};
+            std::from_chars(field.data(), field.data() + field.size(), value);
+            total += value;
+        }
+        return total;
+    });
+    auto columnNs = nsPerNumber(numbers.size(), [&] {
+        return parseColumn(fields, values, invalid);
+    });
+    std::cout << std::setw(8) << type << std::setw(14) << stdNs << std::setw(14) << fromCharsNs
+              << std::setw(14) << columnNs << "   (" << invalid.size() << " invalid)\n";
+}
+
+int main()
+{
+    // 1. errors are values, not exceptions
+    for (std::string_view str : {"189", "-2147483648", "2147483648", "12abc", "abc", ""}) {
+        int value = 0;
+        auto ec = parseNumber(str, value);
+        std::cout << std::setw(12) << ("\"" + std::string{str} + "\"") << " -> ";
+        if (ec == std::errc{}) std::cout << value << "\n";
+        else std::cout << std::make_error_code(ec).message() << "\n";
+    }
+    if (auto opt = parseNumber<double>("3.25")) {
+        std::cout << "parseNumber<double>(\"3.25\") = " << *opt << "\n";
+    }
+    if (auto opt = parseNumber<int64_t>("12345678901234567890"); !opt) {
+        std::cout << "parseNumber<int64_t>(\"12345678901234567890\") = nullopt (out of range)\n\n";
+    }
+
+    // 2. a column with invalid fields
+    std::vector<std::string_view> column {"123", "456", "x7", "-89"};
+    std::vector<int32_t> values;
+    std::vector<size_t> invalid;
+    auto ok = parseColumn(column, values, invalid);
+    std::cout << "parseColumn: " << ok << " converted, 1st invalid index " << invalid.front() << "\n\n";
+
+    // 3. benchmark
+    constexpr size_t count = 5'000'000;
+    std::cout << "    type  std::sto* ns  from_chars ns  parseColumn ns\n";
+    auto ints = makeNumbers(count, false);
+    std::vector<std::string> ints32;
+    for (const auto& s : ints) {
+        if (auto v = parseNumber<int32_t>(s)) ints32.push_back(s); // keep the ones stoi will not throw on
+    }
+    benchmark<int32_t>("int32", ints32, [](const std::string& s) { return std::stoi(s); });
+    benchmark<int64_t>("int64", ints, [](const std::string& s) { return std::stoll(s); });
+    benchmark<double>("double", makeNumbers(count, true), [](const std::string& s) { return std::stod(s); });
+}
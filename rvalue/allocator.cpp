@@ -0,0 +1,423 @@
+/*
+
+Vector with a pluggable allocator (std::pmr::memory_resource).
+Two resources are provided:
+ - Arena: monotonic bump allocator, deallocate is a no-op, everything is released at once with reset()
+ - SizeClassPool: free list per size class (16, 32, ... 4096 bytes), bigger blocks go to the upstream resource
+Both derive from std::pmr::memory_resource so they can be used with any std::pmr container, and any
+std::pmr resource (monotonic_buffer_resource, unsynchronized_pool_resource ...) can be given to Vector.
+
+1) g++ -std=c++17 -O2 -Wall -pedantic allocator.cpp -o allocator
+
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <stdexcept>
+#include <exception>
+#include <algorithm>
+#include <chrono>
+#include <memory_resource>
+#include <vector>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+
+// 1. Monotonic arena: allocating is only bumping a pointer
+
+class Arena : public std::pmr::memory_resource {
+ public:
+    explicit Arena(size_t chunkSize = 64 * 1024,
+                   std::pmr::memory_resource* upstream = std::pmr::new_delete_resource())
+    :m_chunkSize{chunkSize},m_upstream{upstream} {}
+
+    ~Arena() override { releaseChunks(0); }
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    // release everything allocated so far en bloc. The biggest chunk is kept for reuse
+    // so that an arena reset in a loop stops calling the upstream resource after the first iteration
+    void reset();
+
+    size_t bytesUsed() const { return m_used; }
+
+ private:
+    struct Chunk {
+        std::byte* data;
+        size_t size;
+    };
+
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void*, size_t, size_t) override {} // memory is given back by reset()
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    void releaseChunks(size_t keep);
+
+    std::vector<Chunk> m_chunks;
+    std::byte* m_cur = nullptr;
+    std::byte* m_end = nullptr;
+    size_t m_used = 0;
+    size_t m_chunkSize;
+    std::pmr::memory_resource* m_upstream;
+};
+
+void* Arena::do_allocate(size_t bytes, size_t alignment)
+{
+    auto cur = reinterpret_cast<std::uintptr_t>(m_cur);
+    auto aligned = (cur + alignment - 1) & ~(alignment - 1);
+    if (m_cur == nullptr || aligned + bytes > reinterpret_cast<std::uintptr_t>(m_end)) {
+        // new chunk, geometric growth so that a big request does not end up in many small chunks
+        auto size = std::max(m_chunkSize, bytes + alignment);
+        if (!m_chunks.empty()) size = std::max(size, m_chunks.back().size * 2);
+        auto data = static_cast<std::byte*>(m_upstream->allocate(size, alignof(std::max_align_t)));
+        m_chunks.push_back({data, size});
+        m_cur = data;
+        m_end = data + size;
+        aligned = (reinterpret_cast<std::uintptr_t>(m_cur) + alignment - 1) & ~(alignment - 1);
+    }
+    m_used += bytes;
+    m_cur = reinterpret_cast<std::byte*>(aligned + bytes);
+    return reinterpret_cast<void*>(aligned);
+}
+
+void Arena::reset()
+{
+    if (m_chunks.empty()) return;
+    // keep the last one, it is the biggest
+    std::swap(m_chunks.front(), m_chunks.back());
+    releaseChunks(1);
+    m_cur = m_chunks.front().data;
+    m_end = m_cur + m_chunks.front().size;
+    m_used = 0;
+}
+
+void Arena::releaseChunks(size_t keep)
+{
+    for (size_t i = keep; i < m_chunks.size(); ++i) {
+        m_upstream->deallocate(m_chunks[i].data, m_chunks[i].size, alignof(std::max_align_t));
+    }
+    m_chunks.resize(std::min(keep, m_chunks.size()));
+}
+
+
+// 2. Size class pool: one free list per power of 2 size class, blocks are carved from 64KB slabs
+
+class SizeClassPool : public std::pmr::memory_resource {
+ public:
+    explicit SizeClassPool(std::pmr::memory_resource* upstream = std::pmr::new_delete_resource())
+    :m_upstream{upstream} {}
+
+    ~SizeClassPool() override;
+
+    SizeClassPool(const SizeClassPool&) = delete;
+    SizeClassPool& operator=(const SizeClassPool&) = delete;
+
+    static constexpr size_t kMinBlock = 16;
+    static constexpr size_t kMaxBlock = 4096;
+    static constexpr size_t kSlabSize = 64 * 1024;
+
+ private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+    static constexpr size_t kNumClasses = 9; // 16, 32, 64 ... 4096
+
+    static size_t sizeClass(size_t bytes);
+
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    void refill(size_t cls);
+
+    std::array<FreeBlock*, kNumClasses> m_freeLists{};
+    std::vector<std::byte*> m_slabs;
+    std::pmr::memory_resource* m_upstream;
+};
+
+SizeClassPool::~SizeClassPool()
+{
+    for (auto slab : m_slabs) {
+        m_upstream->deallocate(slab, kSlabSize, kMaxBlock);
+    }
+}
+
+size_t SizeClassPool::sizeClass(size_t bytes)
+{
+    size_t cls = 0;
+    for (size_t block = kMinBlock; block < bytes; block *= 2) ++cls;
+    return cls;
+}
+
+void SizeClassPool::refill(size_t cls)
+{
+    // slabs are aligned on kMaxBlock so every block is aligned on its own size
+    auto slab = static_cast<std::byte*>(m_upstream->allocate(kSlabSize, kMaxBlock));
+    m_slabs.push_back(slab);
+    const size_t block = kMinBlock << cls;
+    for (size_t offset = 0; offset + block <= kSlabSize; offset += block) {
+        auto free = reinterpret_cast<FreeBlock*>(slab + offset);
+        free->next = m_freeLists[cls];
+        m_freeLists[cls] = free;
+    }
+}
+
+void* SizeClassPool::do_allocate(size_t bytes, size_t alignment)
+{
+    if (bytes > kMaxBlock || alignment > kMaxBlock) {
+        return m_upstream->allocate(bytes, alignment);
+    }
+    // a block of size 2^k is aligned on 2^k, so take the class big enough for the alignment too
+    auto cls = sizeClass(std::max(bytes, alignment));
+    if (m_freeLists[cls] == nullptr) refill(cls);
+    auto block = m_freeLists[cls];
+    m_freeLists[cls] = block->next;
+    return block;
+}
+
+void SizeClassPool::do_deallocate(void* p, size_t bytes, size_t alignment)
+{
+    if (bytes > kMaxBlock || alignment > kMaxBlock) {
+        m_upstream->deallocate(p, bytes, alignment);
+        return;
+    }
+    auto cls = sizeClass(std::max(bytes, alignment));
+    auto block = static_cast<FreeBlock*>(p);
+    block->next = m_freeLists[cls];
+    m_freeLists[cls] = block;
+}
+
+
+// 3. Per thread arena for short lived temporaries
+// Vector created without an explicit resource use the current one: the default resource (new/delete),
+// or the thread arena while a TemporaryScope is alive. Leaving the outermost scope releases the arena en bloc,
+// so Vectors allocated inside the scope must not outlive it.
+
+Arena& threadArena()
+{
+    thread_local Arena arena;
+    return arena;
+}
+
+thread_local std::pmr::memory_resource* t_currentResource = nullptr;
+
+std::pmr::memory_resource* currentResource()
+{
+    return t_currentResource != nullptr ? t_currentResource : std::pmr::get_default_resource();
+}
+
+class TemporaryScope {
+ public:
+    TemporaryScope():m_previous{t_currentResource} { t_currentResource = &threadArena(); }
+    ~TemporaryScope() {
+        t_currentResource = m_previous;
+        if (m_previous != &threadArena()) threadArena().reset(); // only the outermost scope resets
+    }
+    TemporaryScope(const TemporaryScope&) = delete;
+    TemporaryScope& operator=(const TemporaryScope&) = delete;
+ private:
+    std::pmr::memory_resource* m_previous;
+};
+
+
+// 4. Vector using a memory resource instead of new[]/delete[]
+// Same rules as the std::pmr containers:
+//  - copy ctor does not propagate the resource (uses the current one), move ctor does
+//  - move assignment steals only if both Vectors use the same resource, otherwise it copies
+
+class Vector{
+ private:
+    double* m_elem;
+    size_t m_sz;
+    size_t m_cap;
+    std::pmr::memory_resource* m_res;
+
+    double* allocate(size_t s) { return s == 0 ? nullptr : static_cast<double*>(m_res->allocate(s * sizeof(double), alignof(double))); }
+    void deallocate() { if (m_elem != nullptr) m_res->deallocate(m_elem, m_cap * sizeof(double), alignof(double)); }
+ public:
+    explicit Vector(size_t s, std::pmr::memory_resource* res = currentResource());
+    ~Vector(){deallocate();}
+
+    Vector(const Vector& vec, std::pmr::memory_resource* res = currentResource());
+    Vector& operator=(const Vector& vec);
+
+    Vector( Vector&& vec) noexcept;
+    Vector& operator=( Vector&& vec);
+
+    double& operator[](int i);
+    const double& operator[](int i) const;
+
+    int size() const;
+    size_t capacity() const {return m_cap;}
+    std::pmr::memory_resource* resource() const {return m_res;}
+};
+
+Vector::Vector(size_t s, std::pmr::memory_resource* res)
+:m_elem{nullptr},m_sz{s},m_cap{s},m_res{res}
+{
+    m_elem = allocate(s);
+}
+
+Vector::Vector(const Vector& other, std::pmr::memory_resource* res)
+:m_elem{nullptr},m_sz{other.m_sz},m_cap{other.m_sz},m_res{res}
+{
+    m_elem = allocate(m_cap);
+    std::copy(other.m_elem, other.m_elem + m_sz, m_elem);
+}
+
+Vector& Vector::operator=(const Vector& other)
+{
+    if(this == &other) return *this;
+    if (m_cap < other.m_sz) {           // reallocate only if the current buffer is too small
+        auto elem = allocate(other.m_sz); // allocate first: *this is untouched if it throws
+        deallocate();
+        m_elem = elem;
+        m_cap = other.m_sz;
+    }
+    std::copy(other.m_elem, other.m_elem + other.m_sz, m_elem);
+    m_sz = other.m_sz;
+    return *this;
+}
+
+Vector::Vector(Vector&& other) noexcept
+:m_elem{other.m_elem},m_sz{other.m_sz},m_cap{other.m_cap},m_res{other.m_res}
+{
+    other.m_elem = nullptr;
+    other.m_sz = 0;
+    other.m_cap = 0;
+}
+
+Vector& Vector::operator=(Vector&& other)
+{
+    if (this == &other) return *this;
+    if (*m_res != *other.m_res) {       // memory of other cannot be given back to our resource
+        return *this = static_cast<const Vector&>(other);
+    }
+    deallocate();
+    m_elem = other.m_elem;
+    m_sz = other.m_sz;
+    m_cap = other.m_cap;
+    other.m_elem = nullptr;
+    other.m_sz = 0;
+    other.m_cap = 0;
+    return *this;
+}
+
+const double& Vector::operator[](int i) const
+{
+    if (i < 0 || size() <= i)
+    {
+        throw std::out_of_range{"Vector operator[]: index out of range"};
+    }
+    return m_elem[i];
+}
+
+double& Vector::operator[](int i)
+{
+    if (i < 0 || size() <= i)
+    {
+        throw std::out_of_range{"Vector operator[]: index out of range"};
+    }
+    return m_elem[i];
+}
+
+int Vector::size() const
+{
+    return m_sz;
+}
+
+
+// 5. Benchmark: many short lived temporaries created in a tight loop
+
+Vector MakeTemporary(size_t s, double value)
+{
+    Vector vec(s);      // uses the current resource
+    for (int i = 0; i < vec.size(); ++i) vec[i] = value;
+    return vec;
+}
+
+template<typename F>
+double nsPerIteration(const char* name, size_t iterations, F&& loop)
+{
+    auto start = std::chrono::steady_clock::now();
+    double check = loop(iterations);
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    auto ns = elapsed.count() / iterations;
+    std::cout << std::setw(36) << name << std::setw(10) << ns << " ns  (check " << check << ")\n";
+    return ns;
+}
+
+int main()
+{
+    // 1. copy assignment reuses the buffer when it is big enough
+    std::cout << "1. copy assignment\n";
+    Vector big(8);
+    Vector small(3);
+    small[0] = 1; small[1] = 2; small[2] = 3;
+    big = small;
+    std::cout << "big = small; size: " << big.size() << " capacity: " << big.capacity() << " (no reallocation)\n\n";
+
+    // 2. temporaries carved from the thread arena, released en bloc at the end of the scope
+    std::cout << "2. per thread arena\n";
+    {
+        TemporaryScope scope;
+        Vector tmp1 = MakeTemporary(100, 1.0);
+        Vector tmp2 = MakeTemporary(100, 2.0);
+        std::cout << "arena bytes used: " << threadArena().bytesUsed() << "\n";
+    }
+    std::cout << "arena bytes used after the scope: " << threadArena().bytesUsed() << "\n\n";
+
+    // 3. any std::pmr resource works, e.g. a monotonic buffer on the stack
+    std::cout << "3. std::pmr interop\n";
+    std::array<std::byte, 1024> stackBuffer;
+    std::pmr::monotonic_buffer_resource onStack{stackBuffer.data(), stackBuffer.size(), std::pmr::null_memory_resource()};
+    Vector vs(16, &onStack);
+    SizeClassPool pool;             // and our resources plug into the std::pmr containers
+    std::pmr::vector<int> ints{{1, 2, 3}, &pool};
+    std::cout << "Vector on the stack: " << vs.size() << " elements, pmr::vector in the pool: " << ints.size() << " elements\n";
+    Vector moved(0, &pool);
+    moved = std::move(vs);  // different resources -> elements are copied, not stolen
+    std::cout << "move across resources copied: " << std::boolalpha << (vs.size() == 16) << "\n\n";
+
+    // 4. benchmark
+    std::cout << "4. create/copy/destroy temporaries of 2..64 doubles\n";
+    constexpr size_t iterations = 2'000'000;
+    auto sizeOf = [](size_t i) { return size_t{2} << (i % 6); };
+    auto work = [&](size_t i) {
+        Vector a = MakeTemporary(sizeOf(i), 1.0);
+        Vector b{a};        // copy
+        b = a;              // copy assignment, buffer reused
+        return b[0] + a[a.size() - 1];
+    };
+
+    auto loop = [&](size_t n) {
+        double total = 0.0;
+        for (size_t i = 0; i < n; ++i) total += work(i);
+        return total;
+    };
+
+    auto base = nsPerIteration("new/delete (default resource)", iterations, loop);
+
+    SizeClassPool sizeClassPool;
+    std::pmr::set_default_resource(&sizeClassPool);
+    auto poolNs = nsPerIteration("SizeClassPool", iterations, loop);
+    std::pmr::unsynchronized_pool_resource stdPool;
+    std::pmr::set_default_resource(&stdPool);
+    auto stdPoolNs = nsPerIteration("std::pmr::unsynchronized_pool", iterations, loop);
+    std::pmr::set_default_resource(nullptr);
+
+    auto arenaNs = nsPerIteration("thread arena, reset every 1000 it.", iterations, [&](size_t n) {
+        double total = 0.0;
+        for (size_t batch = 0; batch < n; batch += 1000) {
+            TemporaryScope scope;   // everything allocated in the batch is released at once
+            for (size_t i = batch; i < std::min(n, batch + 1000); ++i) total += work(i);
+        }
+        return total;
+    });
+
+    std::cout << "speedup pool: " << base / poolNs << "x, std pool: " << base / stdPoolNs
+              << "x, arena: " << base / arenaNs << "x\n";
+}
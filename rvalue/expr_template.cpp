@@ -0,0 +1,357 @@
+/*
+
+Expression templates: a = b + c * d is evaluated lazily in one single loop, directly into a.
+operator+ and operator* only build a small object describing the expression (no allocation, no computation);
+the loop runs when the expression is assigned to a Vector.
+
+1) g++ -std=c++17 -O3 -Wall -pedantic expr_template.cpp -o expr_template
+2) g++ -std=c++17 -O3 -Wall -pedantic -fno-elide-constructors expr_template.cpp -o expr_template
+
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <stdexcept>
+#include <exception>
+#include <algorithm>
+#include <chrono>
+#include <cassert>
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+
+
+// 0. Count every heap allocation of the program by replacing the global operator new
+
+size_t g_allocations = 0;
+
+void* operator new(size_t size)
+{
+    ++g_allocations;
+    if (void* p = std::malloc(size == 0 ? 1 : size)) return p;
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+
+// 1. Every expression derives from Expr<E> (CRTP). It gives access to the concrete type without virtual call,
+// so the compiler sees (and inlines) the whole expression tree
+
+template<typename E>
+struct Expr {
+    const E& self() const { return static_cast<const E&>(*this); }
+    double eval(size_t i) const { return self().eval(i); }
+    size_t length() const { return self().length(); }
+};
+
+class Vector : public Expr<Vector> {
+ private:
+    double* m_elem;
+    size_t m_sz;
+ public:
+    explicit Vector(size_t s);
+    ~Vector(){delete[] m_elem;}
+
+    Vector(const Vector& vec);
+    Vector& operator=(const Vector& vec);
+
+    Vector( Vector&& vec) noexcept;
+    Vector& operator=( Vector&& vec) noexcept;
+
+    // evaluate a whole expression in one pass
+    template<typename E>
+    Vector(const Expr<E>& expr);
+    template<typename E>
+    Vector& operator=(const Expr<E>& expr);
+
+    double& operator[](int i);
+    const double& operator[](int i) const;
+
+    int size() const;
+
+    // used by the expressions: no bounds check, sizes are checked once when the expression is built
+    double eval(size_t i) const { return m_elem[i]; }
+    size_t length() const { return m_sz; }
+};
+
+
+// 2. Expression nodes: a leaf Vector is stored by reference, a sub-expression (a small temporary) by value
+
+template<typename E>
+struct Operand {
+    using type = const E;
+};
+
+template<>
+struct Operand<Vector> {
+    using type = const Vector&;
+};
+
+class Scalar : public Expr<Scalar> {
+ public:
+    explicit Scalar(double value):m_value{value} {}
+    double eval(size_t) const { return m_value; }
+    size_t length() const { return 0; } // never compared: a scalar matches any size (see IsScalar)
+ private:
+    double m_value;
+};
+
+template<typename Op, typename L, typename R>
+class BinaryExpr;
+
+// a scalar, or an expression of scalars only: matches the size of the other operand
+template<typename E>
+struct IsScalar : std::false_type {};
+
+template<>
+struct IsScalar<Scalar> : std::true_type {};
+
+template<typename Op, typename L, typename R>
+struct IsScalar<BinaryExpr<Op, L, R>> : std::bool_constant<IsScalar<L>::value && IsScalar<R>::value> {};
+
+template<typename Op, typename L, typename R>
+class BinaryExpr : public Expr<BinaryExpr<Op, L, R>> {
+ public:
+    BinaryExpr(const L& lhs, const R& rhs):m_lhs{lhs},m_rhs{rhs} {
+        if constexpr (!IsScalar<L>::value && !IsScalar<R>::value) {
+            if (lhs.length() != rhs.length()) throw std::length_error{"Vector expression: operands have different sizes"};
+        }
+    }
+    double eval(size_t i) const { return Op::apply(m_lhs.eval(i), m_rhs.eval(i)); }
+    size_t length() const {
+        if constexpr (IsScalar<L>::value) return m_rhs.length();
+        else return m_lhs.length();
+    }
+ private:
+    typename Operand<L>::type m_lhs;
+    typename Operand<R>::type m_rhs;
+};
+
+struct Add { static double apply(double a, double b) { return a + b; } };
+struct Sub { static double apply(double a, double b) { return a - b; } };
+struct Mul { static double apply(double a, double b) { return a * b; } };
+
+template<typename L, typename R>
+BinaryExpr<Add, L, R> operator+(const Expr<L>& lhs, const Expr<R>& rhs) { return {lhs.self(), rhs.self()}; }
+
+template<typename L, typename R>
+BinaryExpr<Sub, L, R> operator-(const Expr<L>& lhs, const Expr<R>& rhs) { return {lhs.self(), rhs.self()}; }
+
+template<typename L, typename R>
+BinaryExpr<Mul, L, R> operator*(const Expr<L>& lhs, const Expr<R>& rhs) { return {lhs.self(), rhs.self()}; }
+
+template<typename R>
+BinaryExpr<Mul, Scalar, R> operator*(double lhs, const Expr<R>& rhs) { return {Scalar{lhs}, rhs.self()}; }
+
+template<typename L>
+BinaryExpr<Mul, L, Scalar> operator*(const Expr<L>& lhs, double rhs) { return {lhs.self(), Scalar{rhs}}; }
+
+
+// 3. Vector
+
+Vector::Vector(size_t s)
+:m_elem{new double[s]},m_sz{s}
+{
+}
+
+Vector::Vector(const Vector& other)
+:m_elem{new double[other.m_sz]},m_sz{other.m_sz}
+{
+    std::copy(other.m_elem, other.m_elem + m_sz, m_elem);
+}
+
+Vector& Vector::operator=(const Vector& other)
+{
+    if(this == &other) return *this;
+    if (m_sz != other.m_sz) {
+        auto elem = new double[other.m_sz];
+        delete[] m_elem;
+        m_elem = elem;
+        m_sz = other.m_sz;
+    }
+    std::copy(other.m_elem, other.m_elem + other.m_sz, m_elem);
+    return *this;
+}
+
+Vector::Vector(Vector&& other) noexcept
+:m_elem{other.m_elem},m_sz{other.m_sz}
+{
+    other.m_elem = nullptr;
+    other.m_sz = 0;
+}
+
+Vector& Vector::operator=(Vector&& other) noexcept
+{
+    if (this == &other) return *this;
+    delete[] m_elem;
+    m_elem = other.m_elem;
+    m_sz = other.m_sz;
+    other.m_elem = nullptr;
+    other.m_sz = 0;
+    return *this;
+}
+
+template<typename E>
+Vector::Vector(const Expr<E>& expr)
+:m_elem{new double[expr.length()]},m_sz{expr.length()}     // the only allocation
+{
+    const auto& e = expr.self();
+    for (size_t i = 0; i < m_sz; ++i) m_elem[i] = e.eval(i); // one fused loop, vectorized at -O3
+}
+
+template<typename E>
+Vector& Vector::operator=(const Expr<E>& expr)
+{
+    const auto& e = expr.self();
+    if (m_sz != e.length()) {
+        // evaluate into a new buffer: the expression may still read our elements (a = a + b)
+        Vector result(e);
+        return *this = std::move(result);
+    }
+    // same size: element i only depends on element i of the operands, in place evaluation is safe
+    for (size_t i = 0; i < m_sz; ++i) m_elem[i] = e.eval(i);
+    return *this;
+}
+
+const double& Vector::operator[](int i) const
+{
+    if (i < 0 || size() <= i)
+    {
+        throw std::out_of_range{"Vector operator[]: index out of range"};
+    }
+    return m_elem[i];
+}
+
+double& Vector::operator[](int i)
+{
+    if (i < 0 || size() <= i)
+    {
+        throw std::out_of_range{"Vector operator[]: index out of range"};
+    }
+    return m_elem[i];
+}
+
+int Vector::size() const
+{
+    return m_sz;
+}
+
+
+// 4. Eager version for comparison: every operation returns a new Vector (one allocation + one loop each)
+
+Vector eagerAdd(const Vector& lhs, const Vector& rhs)
+{
+    Vector result(lhs.size());
+    for (int i = 0; i < lhs.size(); ++i) result[i] = lhs[i] + rhs[i];
+    return result;
+}
+
+Vector eagerMul(const Vector& lhs, const Vector& rhs)
+{
+    Vector result(lhs.size());
+    for (int i = 0; i < lhs.size(); ++i) result[i] = lhs[i] * rhs[i];
+    return result;
+}
+
+Vector eagerScale(double a, const Vector& rhs)
+{
+    Vector result(rhs.size());
+    for (int i = 0; i < rhs.size(); ++i) result[i] = a * rhs[i];
+    return result;
+}
+
+Vector MakeVector(size_t s, double first)
+{
+    Vector vec(s);
+    for (int i = 0; i < vec.size(); ++i) vec[i] = first + i;
+    return vec;
+}
+
+
+// 5. Benchmark helpers
+
+template<typename F>
+double nsPerElement(F&& f, size_t n)
+{
+    size_t reps = std::max<size_t>(3, 50'000'000 / n);
+    f();
+    auto start = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < reps; ++r) f();
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / (static_cast<double>(reps) * n);
+}
+
+int main()
+{
+    Vector b = MakeVector(1000, 1.0);
+    Vector c = MakeVector(1000, 2.0);
+    Vector d = MakeVector(1000, 3.0);
+
+    // 1. allocation counting: one allocation to construct from an expression, none to assign into a Vector of the same size
+    auto before = g_allocations;
+    Vector a = b + c * d;
+    auto construct = g_allocations - before;
+    std::cout << "Vector a = b + c * d;           allocations: " << construct << "\n";
+    assert(construct == 1);
+
+    before = g_allocations;
+    a = b + 2.0 * c * d - a;
+    auto assign = g_allocations - before;
+    std::cout << "a = b + 2.0 * c * d - a;        allocations: " << assign << "\n";
+    assert(assign == 0);
+
+    Vector small(3);
+    before = g_allocations;
+    small = b + c * d;                  // size differs: one allocation for the new buffer
+    auto resize = g_allocations - before;
+    std::cout << "small = b + c * d; (resize)     allocations: " << resize << "\n";
+    assert(resize == 1);
+
+    before = g_allocations;
+    Vector eager = eagerAdd(b, eagerMul(c, d));
+    auto eagerAllocs = g_allocations - before;
+    std::cout << "eagerAdd(b, eagerMul(c, d));    allocations: " << eagerAllocs << "\n";
+
+    // both versions give the same result
+    Vector lazy = b + c * d;
+    for (int i = 0; i < lazy.size(); ++i) {
+        assert(lazy[i] == eager[i]);
+    }
+
+    try {
+        Vector wrong = b + Vector(3);
+    }
+    catch(const std::exception& e) {
+        std::cerr << e.what() << '\n';
+    }
+
+    // an empty Vector is not a scalar: its size is checked like any other
+    bool thrown = false;
+    try {
+        Vector empty(0);
+        Vector wrong = empty + b;
+    }
+    catch(const std::length_error&) {
+        thrown = true;
+    }
+    assert(thrown);
+    Vector scaled = 2.0 * b * 3.0;      // scalars take the size of the vector
+    assert(scaled.size() == b.size() && scaled[5] == 6.0 * b[5]);
+
+    // 2. throughput of a = b + c * d + 2 * e, eager needs 3 temporaries and 4 passes over memory
+    std::cout << "\n        size     eager ns    lazy ns   speedup  (ns per element)\n";
+    for (size_t n = 1000; n <= 10'000'000; n *= 100) {
+        Vector vb = MakeVector(n, 1.0);
+        Vector vc = MakeVector(n, 2.0);
+        Vector vd = MakeVector(n, 3.0);
+        Vector ve = MakeVector(n, 4.0);
+        Vector va(n);
+        auto eagerNs = nsPerElement([&]{ va = eagerAdd(eagerAdd(vb, eagerMul(vc, vd)), eagerScale(2.0, ve)); }, n);
+        auto lazyNs = nsPerElement([&]{ va = vb + vc * vd + 2.0 * ve; }, n);
+        std::cout << std::setw(12) << n << std::setw(13) << eagerNs << std::setw(11) << lazyNs
+                  << std::setw(9) << eagerNs / lazyNs << "x\n";
+    }
+}
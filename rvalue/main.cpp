@@ -6,6 +6,8 @@ To disable Rreturn Value OPtimization RVO use flag -fno-elide-constructors
 1) g++ -std=c++17 -O2 -Wall -pedantic -fno-elide-constructors main.cpp -o main
 2) g++ -std=c++11 -O2 -Wall -pedantic -fno-elide-constructors main.cpp -o main
 3) g++ -std=c++17 -O2 -Wall -pedantic main.cpp -o main
+4) g++ -std=c++17 -O2 -Wall -pedantic -DOP_COUNTERS main.cpp -o main     // count ctors, copies, moves and allocations (see op_counters.h)
+5) g++ -std=c++17 -O2 -Wall -pedantic -DOP_NO_TRACE main.cpp -o main     // no "ctor", "copy ctor"... messages
 
 
 Note: this code is not optimal yet. Copy-and-swap idiom should be used to avoid code duplication and self assignement check. 
@@ -17,6 +19,8 @@ Note: this code is not optimal yet. Copy-and-swap idiom should be used to avoid
 #include <stdexcept>
 #include <exception>
 
+#include "op_counters.h"
+
 
 
 
@@ -26,7 +30,7 @@ class Vector{
     size_t m_sz;
  public:
     explicit Vector(size_t s);
-    ~Vector(){delete[] m_elem;}
+    ~Vector();
 
     Vector(const Vector& vec);
     Vector& operator=(const Vector& vec);
@@ -46,28 +50,43 @@ class Vector{
 
 Vector::Vector(size_t s)
 {
-    std::cout << "ctor" << std::endl;
+    opcounters::trace("ctor");
     if (s < 0)
     {
         throw std::length_error{"Vector ctor: negative size"};
     }
     m_elem = new double[s];
     m_sz=s;
+    opcounters::onConstruct<Vector>();
+    opcounters::onAllocate<Vector>(m_sz * sizeof(double));
+}
+
+Vector::~Vector()
+{
+    opcounters::onDestroy<Vector>();
+    opcounters::onDeallocate<Vector>(m_sz * sizeof(double)); // 0 bytes if moved from
+    delete[] m_elem;
 }
 
  Vector::Vector(const Vector& other)
 :m_elem{new double[other.m_sz]},m_sz{other.m_sz}            // input const -> left untouched; create a new array with the same size
 {
-    std::cout << "copy ctor" << std::endl;
+    opcounters::trace("copy ctor");
+    opcounters::onConstruct<Vector>();
+    opcounters::onCopy<Vector>();
+    opcounters::onAllocate<Vector>(m_sz * sizeof(double));
     std::copy(other.m_elem, other.m_elem + m_sz, m_elem);   // deep copy is required
 }
 
 Vector& Vector::operator=(const Vector& other) // input const -> left untouched
 {
-    std::cout << "copy assignement" << std::endl;
+    opcounters::trace("copy assignement");
     if(this == &other) return *this;    // check for self assignment
+    opcounters::onCopy<Vector>();
+    opcounters::onDeallocate<Vector>(m_sz * sizeof(double));
     delete[] m_elem;
     m_elem = new double[other.m_sz];
+    opcounters::onAllocate<Vector>(other.m_sz * sizeof(double));
     std::copy(other.m_elem, other.m_elem + other.m_sz, m_elem);
     m_sz = other.m_sz;
     return *this;                       // by convention a reference to this class is returned
@@ -77,16 +96,20 @@ Vector& Vector::operator=(const Vector& other) // input const -> left untouched
 :m_elem{other.m_elem},m_sz{other.m_sz}          // steal the data first for the rvalue reference
 {
                                         // no deep copy involved here just moving ressources
-    std::cout << "mv ctor" << std::endl;
+    opcounters::trace("mv ctor");
+    opcounters::onConstruct<Vector>();
+    opcounters::onMove<Vector>();
     other.m_elem = nullptr;               // important to set rvalue ref data to valid state
     other.m_sz = 0;                       // to preven it being accidentally delted when the temporary object dies
 }
  
 Vector& Vector::operator=(Vector&& other)
 {
-    std::cout << "mv assignement" << std::endl;
+    opcounters::trace("mv assignement");
 
     if (this == &other) return *this;    // check for self assignment
+    opcounters::onMove<Vector>();
+    opcounters::onDeallocate<Vector>(m_sz * sizeof(double));
     delete[] m_elem;                      // clean of actual ressource
     m_elem = other.m_elem;
     m_sz = other.m_sz;
@@ -183,6 +206,9 @@ int main()
     //auto vec9 = MakeVectorWrong(); // have compilator warning
     //std::cout << vec9.size(); 
     std::cout << std::endl;
+
+    // with -DOP_COUNTERS: how many copies/moves/allocations really happened (prints nothing otherwise)
+    opcounters::dumpJson(std::cout);
 }
 
 
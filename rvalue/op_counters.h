@@ -0,0 +1,212 @@
+/*
+
+Counters of constructions, copies, moves and allocations per type.
+
+Compile with -DOP_COUNTERS to enable them, otherwise every hook is an empty inline function
+and the compiler removes the calls completely (no atomic, no branch, nothing in the binary).
+Compile with -DOP_NO_TRACE to remove the "copy ctor", "mv ctor"... messages printed by trace().
+
+Counters are atomics (relaxed ordering) so they can be updated from several threads.
+Works with C++11 and later (main.cpp is also built with -std=c++11).
+
+    opcounters::onCopy<Vector>();             // in the copy ctor
+    opcounters::onAllocate<Vector>(bytes);    // after new[]
+    opcounters::get<Vector>().copies;         // query, e.g. from a test
+    opcounters::dumpJson(std::cout);          // all the types seen so far
+
+*/
+
+#ifndef OP_COUNTERS_H
+#define OP_COUNTERS_H
+
+#include <cstdint>
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <utility>
+
+#ifdef OP_COUNTERS
+#include <atomic>
+#include <mutex>
+#include <vector>
+#endif
+
+namespace opcounters {
+
+// plain copy of the counters of one type at a given time
+struct Snapshot {
+    uint64_t constructions = 0; // every ctor, including copy and move ctors
+    uint64_t destructions = 0;
+    uint64_t copies = 0;        // copy ctor + copy assignment
+    uint64_t moves = 0;         // move ctor + move assignment
+    uint64_t allocations = 0;
+    uint64_t bytesAllocated = 0;
+    uint64_t liveBytes = 0;
+    uint64_t peakLiveBytes = 0;
+};
+
+inline void trace(const char* msg)
+{
+#ifndef OP_NO_TRACE
+    std::cout << msg << std::endl;
+#else
+    (void)msg;
+#endif
+}
+
+#ifdef OP_COUNTERS
+
+constexpr bool enabled = true;
+
+struct Counters {
+    explicit Counters(std::string typeName):name{std::move(typeName)} {}
+
+    std::string name;
+    std::atomic<uint64_t> constructions{0};
+    std::atomic<uint64_t> destructions{0};
+    std::atomic<uint64_t> copies{0};
+    std::atomic<uint64_t> moves{0};
+    std::atomic<uint64_t> allocations{0};
+    std::atomic<uint64_t> bytesAllocated{0};
+    std::atomic<uint64_t> liveBytes{0};
+    std::atomic<uint64_t> peakLiveBytes{0};
+};
+
+// every type registers its counters the first time a hook is called
+struct Registry {
+    std::mutex mutex;
+    std::vector<Counters*> counters;
+};
+
+inline Registry& registry()
+{
+    static Registry reg;
+    return reg;
+}
+
+// type name extracted from __PRETTY_FUNCTION__ (GCC: "... [with T = Vector]", clang: "... [T = Vector]")
+template<typename T>
+std::string typeName()
+{
+    const std::string pretty = __PRETTY_FUNCTION__;
+    const auto start = pretty.find("T = ") + 4;
+    auto end = pretty.find("; ", start);  // GCC also lists the other aliases: "[with T = Vector; std::string = ...]"
+    if (end == std::string::npos) end = pretty.rfind(']');
+    return pretty.substr(start, end - start);
+}
+
+template<typename T>
+Counters& countersOf()
+{
+    static Counters* counters = [] {
+        auto c = new Counters{typeName<T>()};   // never deleted: still valid when dumped at exit
+        std::lock_guard<std::mutex> lock{registry().mutex};
+        registry().counters.push_back(c);
+        return c;
+    }();
+    return *counters;
+}
+
+inline Snapshot snapshot(const Counters& c)
+{
+    Snapshot s;
+    s.constructions = c.constructions.load(std::memory_order_relaxed);
+    s.destructions = c.destructions.load(std::memory_order_relaxed);
+    s.copies = c.copies.load(std::memory_order_relaxed);
+    s.moves = c.moves.load(std::memory_order_relaxed);
+    s.allocations = c.allocations.load(std::memory_order_relaxed);
+    s.bytesAllocated = c.bytesAllocated.load(std::memory_order_relaxed);
+    s.liveBytes = c.liveBytes.load(std::memory_order_relaxed);
+    s.peakLiveBytes = c.peakLiveBytes.load(std::memory_order_relaxed);
+    return s;
+}
+
+template<typename T>
+void onConstruct() { countersOf<T>().constructions.fetch_add(1, std::memory_order_relaxed); }
+
+template<typename T>
+void onDestroy() { countersOf<T>().destructions.fetch_add(1, std::memory_order_relaxed); }
+
+template<typename T>
+void onCopy() { countersOf<T>().copies.fetch_add(1, std::memory_order_relaxed); }
+
+template<typename T>
+void onMove() { countersOf<T>().moves.fetch_add(1, std::memory_order_relaxed); }
+
+template<typename T>
+void onAllocate(size_t bytes)
+{
+    auto& c = countersOf<T>();
+    c.allocations.fetch_add(1, std::memory_order_relaxed);
+    c.bytesAllocated.fetch_add(bytes, std::memory_order_relaxed);
+    auto live = c.liveBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    auto peak = c.peakLiveBytes.load(std::memory_order_relaxed);
+    while (live > peak && !c.peakLiveBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+    }
+}
+
+template<typename T>
+void onDeallocate(size_t bytes) { countersOf<T>().liveBytes.fetch_sub(bytes, std::memory_order_relaxed); }
+
+template<typename T>
+Snapshot get() { return snapshot(countersOf<T>()); }
+
+// set every counter back to 0 (e.g. between 2 tests), peak is set to the current live bytes
+inline void reset()
+{
+    std::lock_guard<std::mutex> lock{registry().mutex};
+    for (auto c : registry().counters) {
+        c->constructions = 0;
+        c->destructions = 0;
+        c->copies = 0;
+        c->moves = 0;
+        c->allocations = 0;
+        c->bytesAllocated = 0;
+        c->peakLiveBytes = c->liveBytes.load();
+    }
+}
+
+inline void dumpJson(std::ostream& out)
+{
+    std::lock_guard<std::mutex> lock{registry().mutex};
+    out << "{\n";
+    const auto& all = registry().counters;
+    for (size_t i = 0; i < all.size(); ++i) {
+        auto s = snapshot(*all[i]);
+        out << "  \"";
+        for (char ch : all[i]->name) {      // type names may contain '"' or '\' only in theory, escape anyway
+            if (ch == '"' || ch == '\\') out << '\\';
+            out << ch;
+        }
+        out << "\": {\"constructions\": " << s.constructions
+            << ", \"destructions\": " << s.destructions
+            << ", \"copies\": " << s.copies
+            << ", \"moves\": " << s.moves
+            << ", \"allocations\": " << s.allocations
+            << ", \"bytes_allocated\": " << s.bytesAllocated
+            << ", \"live_bytes\": " << s.liveBytes
+            << ", \"peak_live_bytes\": " << s.peakLiveBytes << "}"
+            << (i + 1 < all.size() ? "," : "") << "\n";
+    }
+    out << "}\n";
+}
+
+#else // OP_COUNTERS disabled: every hook is empty and inlined away
+
+constexpr bool enabled = false;
+
+template<typename T> void onConstruct() {}
+template<typename T> void onDestroy() {}
+template<typename T> void onCopy() {}
+template<typename T> void onMove() {}
+template<typename T> void onAllocate(size_t) {}
+template<typename T> void onDeallocate(size_t) {}
+template<typename T> Snapshot get() { return {}; }
+inline void reset() {}
+inline void dumpJson(std::ostream&) {}
+
+#endif // OP_COUNTERS
+
+} // namespace opcounters
+
+#endif // OP_COUNTERS_H
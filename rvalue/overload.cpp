@@ -2,6 +2,8 @@
 Only works with c++17
 
 1) g++ -std=c++17 -O2 -Wall -pedantic dedguide.cpp -o dedguide
+2) g++ -std=c++17 -O2 -Wall -pedantic -DOP_COUNTERS dedguide.cpp -o dedguide    // count ctors, copies and moves (see op_counters.h), asserts the counts
+3) g++ -std=c++17 -O2 -Wall -pedantic -DOP_NO_TRACE dedguide.cpp -o dedguide    // no trace, also times 10M displayers from the catalogue
 
 */
 
@@ -9,13 +11,28 @@ Only works with c++17
 #include <string>
 #include <sstream>
 #include <vector>
+#include <string_view>
+#include <chrono>
+#include <cassert>
+#include <type_traits>
+#include <utility>
+
+#include "op_counters.h"
+#include "text_catalog.h"
+
+// the book is built once, at the first call, then only views on it are returned (no copy)
+const std::shared_ptr<const TextCatalog>& book() {
+    static const auto catalog = [] {
+        TextCatalog::Builder builder;
+        builder.add("Hello");
+        builder.add("Bye");
+        return builder.build();
+    }();
+    return catalog;
+}
 
-std::string get_from_index(int idx) {
-    std::vector<std::string> book;
-    book.emplace_back("Hello");
-    book.emplace_back("Bye");
-
-    return book[idx];
+std::string_view get_from_index(int idx) {
+    return (*book())[idx];
 }
 
 template<class T>
@@ -25,16 +42,52 @@ class TextDisplayer
 {
     public:
         explicit TextDisplayer(T&& text) : m_text(std::forward<T>(text)) {
-            std::cout << "ctor fw" << std::endl;
+            opcounters::trace("ctor fw");
+            opcounters::onConstruct<TextDisplayer>();
         }
 
         explicit TextDisplayer(int idx) : m_text(get_from_index(idx)) {
-            std::cout << "ctor int" << std::endl;
+            opcounters::trace("ctor int");
+            opcounters::onConstruct<TextDisplayer>();
+        }
+
+        TextDisplayer(const TextDisplayer& other) : m_text(other.m_text) {
+            opcounters::onConstruct<TextDisplayer>();
+            opcounters::onCopy<TextDisplayer>();
+        }
+
+        TextDisplayer(TextDisplayer&& other) noexcept(std::is_nothrow_constructible_v<T, T&&>) : m_text(std::forward<T>(other.m_text)) { // moves only if T is not a reference
+            opcounters::onConstruct<TextDisplayer>();
+            opcounters::onMove<TextDisplayer>();
+        }
+
+        // a reference member cannot be reseated: only the displayers which own their text are assignable
+        TextDisplayer& operator=(const TextDisplayer& other) {
+            static_assert(!std::is_reference_v<T>, "TextDisplayer of a reference is not assignable");
+            m_text = other.m_text;
+            opcounters::onCopy<TextDisplayer>();
+            return *this;
+        }
+
+        TextDisplayer& operator=(TextDisplayer&& other) noexcept(std::is_nothrow_move_assignable_v<T>) {
+            static_assert(!std::is_reference_v<T>, "TextDisplayer of a reference is not assignable");
+            m_text = std::move(other.m_text);
+            opcounters::onMove<TextDisplayer>();
+            return *this;
+        }
+
+        ~TextDisplayer() {
+            opcounters::onDestroy<TextDisplayer>();
         }
 
         void show() {
             std::cout << m_text << std::endl;
         }
+
+        void show(LineBatch& batch) const {
+            batch.add(m_text); // written later with the other lines, in one call
+        }
+        const T& text() const { return m_text; }
     private:
     T m_text;
 };
@@ -64,4 +117,48 @@ int main()
     displayer1.show();
     displayer2.show();
     displayer3.show();
+
+    // zero copy displayers: they only hold a view on the catalogue, no allocation, no string copy
+    TextDisplayer<std::string_view> viewDisplayer(1);                 // string_view on "Bye"
+    TextDisplayer sliceDisplayer(book()->slice(0));                   // TextSlice, keeps the catalogue alive
+    {
+        LineBatch batch;
+        viewDisplayer.show(batch);
+        sliceDisplayer.show(batch);
+        displayer1.show(batch);
+    }                                                                 // the 3 lines are written here at once
+
+    // noexcept move: a std::vector of displayers moves them when it grows instead of copying them
+    static_assert(std::is_nothrow_move_constructible_v<TextDisplayer<std::string>>);
+    std::vector<TextDisplayer<std::string>> owners;
+    owners.emplace_back(0);
+    owners.emplace_back(1);                                           // moves "Hello" to the new buffer
+    owners.front() = owners.back();                                   // copy assignment, counted
+#ifdef OP_COUNTERS
+    // the real counts: one move when the vector grows, one copy assignment, nothing else
+    const auto counts = opcounters::get<TextDisplayer<std::string>>();
+    assert(counts.copies == 1 && counts.moves == 1);
+#endif
+
+#ifdef OP_NO_TRACE // otherwise "ctor int" is printed 20M times
+    constexpr size_t count = 10'000'000;
+    size_t totalSize = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i) {
+        TextDisplayer<std::string_view> d(i % 2);
+        totalSize += std::string_view{d.text()}.size();
+    }
+    std::chrono::duration<double, std::nano> viewNs = std::chrono::steady_clock::now() - start;
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i) {
+        TextDisplayer<std::string> d(i % 2);
+        totalSize += d.text().size();
+    }
+    std::chrono::duration<double, std::nano> stringNs = std::chrono::steady_clock::now() - start;
+    std::cout << "TextDisplayer<std::string_view>(idx): " << viewNs.count() / count << " ns, "
+              << "TextDisplayer<std::string>(idx): " << stringNs.count() / count << " ns (" << totalSize << ")\n";
+#endif
+
+    // with -DOP_COUNTERS: one entry per TextDisplayer<T> (prints nothing otherwise)
+    opcounters::dumpJson(std::cout);
 }
\ No newline at end of file
@@ -0,0 +1,572 @@
+/*
+
+Bulk operations on Vector using SIMD kernels (AVX2 / SSE2) with a scalar fallback.
+The best kernel set is selected once at runtime according to the CPU (__builtin_cpu_supports).
+Each kernel is compiled with its own target attribute so there is no need to pass -mavx2:
+the binary still runs on a CPU without AVX2.
+
+1) g++ -std=c++17 -O2 -Wall -pedantic simd.cpp -o simd
+2) ./simd             // benchmark from 1K up to 10M elements
+3) ./simd 100000000   // benchmark from 1K up to 100M elements (needs ~2.4GB of RAM)
+
+*/
+
+#include "../common/bench.h"
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <stdexcept>
+#include <exception>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <limits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define VECTOR_SIMD_X86
+#endif
+
+
+constexpr size_t kAlignment = 64; // one cache line, enough for AVX and AVX-512 loads
+
+class Vector{
+ private:
+    double* m_elem;
+    size_t m_sz;
+
+    static double* allocate(size_t s);
+ public:
+    explicit Vector(size_t s);
+    ~Vector(){std::free(m_elem);}
+
+    Vector(const Vector& vec);
+    Vector& operator=(const Vector& vec);
+
+    Vector( Vector&& vec) noexcept;
+    Vector& operator=( Vector&& vec) noexcept;
+
+    double& operator[](int i);
+    const double& operator[](int i) const;
+
+    // unchecked access to the aligned storage, used by the bulk operations
+    double* data() {return m_elem;}
+    const double* data() const {return m_elem;}
+
+    int size() const;
+};
+
+double* Vector::allocate(size_t s)
+{
+    if (s == 0) return nullptr;
+    // aligned_alloc requires a size multiple of the alignment
+    auto bytes = (s * sizeof(double) + kAlignment - 1) / kAlignment * kAlignment;
+    auto elem = static_cast<double*>(std::aligned_alloc(kAlignment, bytes));
+    if (elem == nullptr) throw std::bad_alloc{};
+    return elem;
+}
+
+Vector::Vector(size_t s)
+:m_elem{allocate(s)},m_sz{s}
+{
+}
+
+Vector::Vector(const Vector& other)
+:m_elem{allocate(other.m_sz)},m_sz{other.m_sz}
+{
+    std::copy(other.m_elem, other.m_elem + m_sz, m_elem);
+}
+
+Vector& Vector::operator=(const Vector& other)
+{
+    if(this == &other) return *this;
+    if (m_sz != other.m_sz) {
+        std::free(m_elem);
+        m_elem = nullptr;           // keep a valid state if allocate throws
+        m_sz = 0;
+        m_elem = allocate(other.m_sz);
+        m_sz = other.m_sz;
+    }
+    std::copy(other.m_elem, other.m_elem + other.m_sz, m_elem);
+    return *this;
+}
+
+Vector::Vector(Vector&& other) noexcept
+:m_elem{other.m_elem},m_sz{other.m_sz}
+{
+    other.m_elem = nullptr;
+    other.m_sz = 0;
+}
+
+Vector& Vector::operator=(Vector&& other) noexcept
+{
+    if (this == &other) return *this;
+    std::free(m_elem);
+    m_elem = other.m_elem;
+    m_sz = other.m_sz;
+    other.m_elem = nullptr;
+    other.m_sz = 0;
+    return *this;
+}
+
+const double& Vector::operator[](int i) const
+{
+    if (i < 0 || size() <= i)
+    {
+        throw std::out_of_range{"Vector operator[]: index out of range"};
+    }
+    return m_elem[i];
+}
+
+double& Vector::operator[](int i)
+{
+    if (i < 0 || size() <= i)
+    {
+        throw std::out_of_range{"Vector operator[]: index out of range"};
+    }
+    return m_elem[i];
+}
+
+int Vector::size() const
+{
+    return m_sz;
+}
+
+
+// 1. Kernels: one implementation per instruction set, all with the same signatures
+
+struct Kernels {
+    const char* name;
+    void   (*axpy)(double a, const double* x, double* y, size_t n);            // y = a * x + y
+    double (*dot)(const double* x, const double* y, size_t n);
+    double (*sum)(const double* x, size_t n);
+    double (*min)(const double* x, size_t n);
+    double (*max)(const double* x, size_t n);
+    void   (*add)(const double* x, const double* y, double* out, size_t n);    // out = x + y
+    void   (*mul)(const double* x, const double* y, double* out, size_t n);    // out = x * y
+    void   (*scale)(double a, double* x, size_t n);                            // x = a * x
+};
+
+namespace scalar {
+
+void axpy(double a, const double* x, double* y, size_t n) {
+    for (size_t i = 0; i < n; ++i) y[i] += a * x[i];
+}
+
+double dot(const double* x, const double* y, size_t n) {
+    double s = 0.0;
+    for (size_t i = 0; i < n; ++i) s += x[i] * y[i];
+    return s;
+}
+
+double sum(const double* x, size_t n) {
+    double s = 0.0;
+    for (size_t i = 0; i < n; ++i) s += x[i];
+    return s;
+}
+
+double min(const double* x, size_t n) {
+    double m = std::numeric_limits<double>::infinity();
+    for (size_t i = 0; i < n; ++i) m = x[i] < m ? x[i] : m;
+    return m;
+}
+
+double max(const double* x, size_t n) {
+    double m = -std::numeric_limits<double>::infinity();
+    for (size_t i = 0; i < n; ++i) m = x[i] > m ? x[i] : m;
+    return m;
+}
+
+void add(const double* x, const double* y, double* out, size_t n) {
+    for (size_t i = 0; i < n; ++i) out[i] = x[i] + y[i];
+}
+
+void mul(const double* x, const double* y, double* out, size_t n) {
+    for (size_t i = 0; i < n; ++i) out[i] = x[i] * y[i];
+}
+
+void scale(double a, double* x, size_t n) {
+    for (size_t i = 0; i < n; ++i) x[i] *= a;
+}
+
+constexpr Kernels kernels {"scalar", axpy, dot, sum, min, max, add, mul, scale};
+
+} // namespace scalar
+
+#ifdef VECTOR_SIMD_X86
+
+// Storage of Vector is aligned but the kernels use unaligned loads/stores (loadu/storeu):
+// on aligned addresses they are as fast as the aligned ones and they also accept sub-ranges.
+// Reductions use several accumulators to hide the latency of the add/fma instructions.
+// Note: the summation order differs from the scalar loop, results can differ in the last bits.
+
+namespace sse2 {
+
+#define SSE2_TARGET __attribute__((target("sse2")))
+
+SSE2_TARGET inline double hsum(__m128d v) {
+    return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+}
+
+SSE2_TARGET void axpy(double a, const double* x, double* y, size_t n) {
+    const __m128d va = _mm_set1_pd(a);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        _mm_storeu_pd(y + i, _mm_add_pd(_mm_mul_pd(va, _mm_loadu_pd(x + i)), _mm_loadu_pd(y + i)));
+    }
+    for (; i < n; ++i) y[i] += a * x[i];
+}
+
+SSE2_TARGET double dot(const double* x, const double* y, size_t n) {
+    __m128d acc0 = _mm_setzero_pd();
+    __m128d acc1 = _mm_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        acc0 = _mm_add_pd(acc0, _mm_mul_pd(_mm_loadu_pd(x + i), _mm_loadu_pd(y + i)));
+        acc1 = _mm_add_pd(acc1, _mm_mul_pd(_mm_loadu_pd(x + i + 2), _mm_loadu_pd(y + i + 2)));
+    }
+    double s = hsum(_mm_add_pd(acc0, acc1));
+    for (; i < n; ++i) s += x[i] * y[i];
+    return s;
+}
+
+SSE2_TARGET double sum(const double* x, size_t n) {
+    __m128d acc0 = _mm_setzero_pd();
+    __m128d acc1 = _mm_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        acc0 = _mm_add_pd(acc0, _mm_loadu_pd(x + i));
+        acc1 = _mm_add_pd(acc1, _mm_loadu_pd(x + i + 2));
+    }
+    double s = hsum(_mm_add_pd(acc0, acc1));
+    for (; i < n; ++i) s += x[i];
+    return s;
+}
+
+SSE2_TARGET double min(const double* x, size_t n) {
+    __m128d acc = _mm_set1_pd(std::numeric_limits<double>::infinity());
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) acc = _mm_min_pd(acc, _mm_loadu_pd(x + i));
+    double m = std::min(_mm_cvtsd_f64(acc), _mm_cvtsd_f64(_mm_unpackhi_pd(acc, acc)));
+    for (; i < n; ++i) m = x[i] < m ? x[i] : m;
+    return m;
+}
+
+SSE2_TARGET double max(const double* x, size_t n) {
+    __m128d acc = _mm_set1_pd(-std::numeric_limits<double>::infinity());
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) acc = _mm_max_pd(acc, _mm_loadu_pd(x + i));
+    double m = std::max(_mm_cvtsd_f64(acc), _mm_cvtsd_f64(_mm_unpackhi_pd(acc, acc)));
+    for (; i < n; ++i) m = x[i] > m ? x[i] : m;
+    return m;
+}
+
+SSE2_TARGET void add(const double* x, const double* y, double* out, size_t n) {
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) _mm_storeu_pd(out + i, _mm_add_pd(_mm_loadu_pd(x + i), _mm_loadu_pd(y + i)));
+    for (; i < n; ++i) out[i] = x[i] + y[i];
+}
+
+SSE2_TARGET void mul(const double* x, const double* y, double* out, size_t n) {
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) _mm_storeu_pd(out + i, _mm_mul_pd(_mm_loadu_pd(x + i), _mm_loadu_pd(y + i)));
+    for (; i < n; ++i) out[i] = x[i] * y[i];
+}
+
+SSE2_TARGET void scale(double a, double* x, size_t n) {
+    const __m128d va = _mm_set1_pd(a);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) _mm_storeu_pd(x + i, _mm_mul_pd(va, _mm_loadu_pd(x + i)));
+    for (; i < n; ++i) x[i] *= a;
+}
+
+#undef SSE2_TARGET
+
+constexpr Kernels kernels {"sse2", axpy, dot, sum, min, max, add, mul, scale};
+
+} // namespace sse2
+
+namespace avx2 {
+
+#define AVX2_TARGET __attribute__((target("avx2,fma")))
+
+AVX2_TARGET inline double hsum(__m256d v) {
+    __m128d lo = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(lo, _mm_unpackhi_pd(lo, lo)));
+}
+
+AVX2_TARGET void axpy(double a, const double* x, double* y, size_t n) {
+    const __m256d va = _mm256_set1_pd(a);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm256_storeu_pd(y + i, _mm256_fmadd_pd(va, _mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+    }
+    for (; i < n; ++i) y[i] += a * x[i];
+}
+
+AVX2_TARGET double dot(const double* x, const double* y, size_t n) {
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    __m256d acc2 = _mm256_setzero_pd();
+    __m256d acc3 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i), acc0);
+        acc1 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i + 4), _mm256_loadu_pd(y + i + 4), acc1);
+        acc2 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i + 8), _mm256_loadu_pd(y + i + 8), acc2);
+        acc3 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i + 12), _mm256_loadu_pd(y + i + 12), acc3);
+    }
+    for (; i + 4 <= n; i += 4) acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i), acc0);
+    double s = hsum(_mm256_add_pd(_mm256_add_pd(acc0, acc1), _mm256_add_pd(acc2, acc3)));
+    for (; i < n; ++i) s += x[i] * y[i];
+    return s;
+}
+
+AVX2_TARGET double sum(const double* x, size_t n) {
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    __m256d acc2 = _mm256_setzero_pd();
+    __m256d acc3 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        acc0 = _mm256_add_pd(acc0, _mm256_loadu_pd(x + i));
+        acc1 = _mm256_add_pd(acc1, _mm256_loadu_pd(x + i + 4));
+        acc2 = _mm256_add_pd(acc2, _mm256_loadu_pd(x + i + 8));
+        acc3 = _mm256_add_pd(acc3, _mm256_loadu_pd(x + i + 12));
+    }
+    for (; i + 4 <= n; i += 4) acc0 = _mm256_add_pd(acc0, _mm256_loadu_pd(x + i));
+    double s = hsum(_mm256_add_pd(_mm256_add_pd(acc0, acc1), _mm256_add_pd(acc2, acc3)));
+    for (; i < n; ++i) s += x[i];
+    return s;
+}
+
+AVX2_TARGET double min(const double* x, size_t n) {
+    __m256d acc = _mm256_set1_pd(std::numeric_limits<double>::infinity());
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) acc = _mm256_min_pd(acc, _mm256_loadu_pd(x + i));
+    __m128d m2 = _mm_min_pd(_mm256_castpd256_pd128(acc), _mm256_extractf128_pd(acc, 1));
+    double m = std::min(_mm_cvtsd_f64(m2), _mm_cvtsd_f64(_mm_unpackhi_pd(m2, m2)));
+    for (; i < n; ++i) m = x[i] < m ? x[i] : m;
+    return m;
+}
+
+AVX2_TARGET double max(const double* x, size_t n) {
+    __m256d acc = _mm256_set1_pd(-std::numeric_limits<double>::infinity());
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) acc = _mm256_max_pd(acc, _mm256_loadu_pd(x + i));
+    __m128d m2 = _mm_max_pd(_mm256_castpd256_pd128(acc), _mm256_extractf128_pd(acc, 1));
+    double m = std::max(_mm_cvtsd_f64(m2), _mm_cvtsd_f64(_mm_unpackhi_pd(m2, m2)));
+    for (; i < n; ++i) m = x[i] > m ? x[i] : m;
+    return m;
+}
+
+AVX2_TARGET void add(const double* x, const double* y, double* out, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) _mm256_storeu_pd(out + i, _mm256_add_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+    for (; i < n; ++i) out[i] = x[i] + y[i];
+}
+
+AVX2_TARGET void mul(const double* x, const double* y, double* out, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) _mm256_storeu_pd(out + i, _mm256_mul_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+    for (; i < n; ++i) out[i] = x[i] * y[i];
+}
+
+AVX2_TARGET void scale(double a, double* x, size_t n) {
+    const __m256d va = _mm256_set1_pd(a);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) _mm256_storeu_pd(x + i, _mm256_mul_pd(va, _mm256_loadu_pd(x + i)));
+    for (; i < n; ++i) x[i] *= a;
+}
+
+#undef AVX2_TARGET
+
+constexpr Kernels kernels {"avx2", axpy, dot, sum, min, max, add, mul, scale};
+
+} // namespace avx2
+
+#endif // VECTOR_SIMD_X86
+
+
+// 2. Runtime dispatch: the CPU is queried only once, the first time a bulk operation is called
+
+const Kernels& selectKernels() {
+#ifdef VECTOR_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return avx2::kernels;
+    if (__builtin_cpu_supports("sse2")) return sse2::kernels;
+#endif
+    return scalar::kernels;
+}
+
+const Kernels& kernels() {
+    static const Kernels& selected = selectKernels(); // thread safe init. since C++11
+    return selected;
+}
+
+
+// 3. Bulk operations on Vector. Sizes are checked once per call instead of once per element
+
+void checkSameSize(const Vector& x, const Vector& y, const char* what) {
+    if (x.size() != y.size()) {
+        throw std::length_error{std::string{what} + ": vectors have different sizes"};
+    }
+}
+
+void axpy(double a, const Vector& x, Vector& y) {
+    checkSameSize(x, y, "axpy");
+    kernels().axpy(a, x.data(), y.data(), x.size());
+}
+
+double dot(const Vector& x, const Vector& y) {
+    checkSameSize(x, y, "dot");
+    return kernels().dot(x.data(), y.data(), x.size());
+}
+
+double sum(const Vector& x) {
+    return kernels().sum(x.data(), x.size());
+}
+
+double min(const Vector& x) {
+    if (x.size() == 0) throw std::length_error{"min: empty Vector"};
+    return kernels().min(x.data(), x.size());
+}
+
+double max(const Vector& x) {
+    if (x.size() == 0) throw std::length_error{"max: empty Vector"};
+    return kernels().max(x.data(), x.size());
+}
+
+void add(const Vector& x, const Vector& y, Vector& out) {
+    checkSameSize(x, y, "add");
+    checkSameSize(x, out, "add");
+    kernels().add(x.data(), y.data(), out.data(), x.size());
+}
+
+void mul(const Vector& x, const Vector& y, Vector& out) {
+    checkSameSize(x, y, "mul");
+    checkSameSize(x, out, "mul");
+    kernels().mul(x.data(), y.data(), out.data(), x.size());
+}
+
+void scale(double a, Vector& x) {
+    kernels().scale(a, x.data(), x.size());
+}
+
+
+// 4. Reference: the loops we used to write with the bounds checked operator[]
+
+double dotIndexed(const Vector& x, const Vector& y) {
+    double s = 0.0;
+    for (int i = 0; i < x.size(); ++i) s += x[i] * y[i];
+    return s;
+}
+
+double sumIndexed(const Vector& x) {
+    double s = 0.0;
+    for (int i = 0; i < x.size(); ++i) s += x[i];
+    return s;
+}
+
+void axpyIndexed(double a, const Vector& x, Vector& y) {
+    for (int i = 0; i < x.size(); ++i) y[i] += a * x[i];
+}
+
+void addIndexed(const Vector& x, const Vector& y, Vector& out) {
+    for (int i = 0; i < x.size(); ++i) out[i] = x[i] + y[i];
+}
+
+double maxIndexed(const Vector& x) {
+    double m = x[0];
+    for (int i = 1; i < x.size(); ++i) m = x[i] > m ? x[i] : m;
+    return m;
+}
+
+
+// 5. Benchmark helpers
+
+template<typename F>
+double nsPerElement(F&& f, size_t n) {
+    // repeat so that each measure touches at least ~50M elements (but at least 3 times)
+    size_t reps = std::max<size_t>(3, 50'000'000 / n);
+    f(); // warm up: page faults, caches
+    auto start = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < reps; ++r) f();
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / (static_cast<double>(reps) * n);
+}
+
+void report(const char* op, size_t n, double indexed, double scalarK, double simd) {
+    std::cout << std::setw(6) << op << std::setw(12) << n
+              << std::setw(12) << indexed << std::setw(12) << scalarK << std::setw(12) << simd
+              << std::setw(10) << indexed / simd << "x\n";
+}
+
+int main(int argc, char* argv[])
+{
+    // 1. Correctness check against the scalar version on an odd size (exercises the tails)
+    Vector x(1003);
+    Vector y(1003);
+    for (int i = 0; i < x.size(); ++i) {
+        x[i] = (i % 17) - 8.0;
+        y[i] = (i % 5) * 0.5;
+    }
+    std::cout << "selected kernels: " << kernels().name << "\n";
+    std::cout << "dot: " << dot(x, y) << " (indexed " << dotIndexed(x, y) << ")\n";
+    std::cout << "sum: " << sum(x) << " (indexed " << sumIndexed(x) << ")\n";
+    std::cout << "min: " << min(x) << " max: " << max(x) << " (indexed max " << maxIndexed(x) << ")\n";
+
+    Vector out(x.size());
+    add(x, y, out);
+    mul(out, y, out);           // in place is allowed
+    scale(2.0, out);
+    axpy(0.5, x, out);          // out = 2 * (x + y) * y + 0.5 * x
+    bool ok = true;
+    for (int i = 0; i < x.size(); ++i) {
+        ok = ok && (out[i] == 2.0 * (x[i] + y[i]) * y[i] + 0.5 * x[i]);
+    }
+    std::cout << "element-wise add/mul/scale/axpy match: " << std::boolalpha << ok << "\n\n";
+
+    try {
+        Vector z(3);
+        dot(x, z);
+    }
+    catch(const std::exception& e) {
+        std::cerr << e.what() << '\n';
+    }
+
+    // 2. Benchmark: ns per element, bounds checked loop vs scalar kernel vs dispatched SIMD kernel
+    size_t maxSize = argc > 1 ? std::stoul(argv[1]) : 10'000'000;
+    std::cout << "\n    op        size  indexed ns   scalar ns     " << kernels().name << " ns   speedup\n";
+    for (size_t n = 1000; n <= maxSize; n *= 10) {
+        Vector a(n);
+        Vector b(n);
+        Vector c(n);
+        for (size_t i = 0; i < n; ++i) {
+            a.data()[i] = static_cast<double>(i % 100);
+            b.data()[i] = 1.0 / (1 + i % 7);
+        }
+        report("dot", n,
+               nsPerElement([&]{ bench::keep(dotIndexed(a, b)); }, n),
+               nsPerElement([&]{ bench::keep(scalar::dot(a.data(), b.data(), n)); }, n),
+               nsPerElement([&]{ bench::keep(dot(a, b)); }, n));
+        report("sum", n,
+               nsPerElement([&]{ bench::keep(sumIndexed(a)); }, n),
+               nsPerElement([&]{ bench::keep(scalar::sum(a.data(), n)); }, n),
+               nsPerElement([&]{ bench::keep(sum(a)); }, n));
+        report("max", n,
+               nsPerElement([&]{ bench::keep(maxIndexed(a)); }, n),
+               nsPerElement([&]{ bench::keep(scalar::max(a.data(), n)); }, n),
+               nsPerElement([&]{ bench::keep(max(a)); }, n));
+        report("axpy", n,
+               nsPerElement([&]{ axpyIndexed(1e-9, a, c); }, n),
+               nsPerElement([&]{ scalar::axpy(1e-9, a.data(), c.data(), n); }, n),
+               nsPerElement([&]{ axpy(1e-9, a, c); }, n));
+        report("add", n,
+               nsPerElement([&]{ addIndexed(a, b, c); }, n),
+               nsPerElement([&]{ scalar::add(a.data(), b.data(), c.data(), n); }, n),
+               nsPerElement([&]{ add(a, b, c); }, n));
+        std::cout << "\n";
+    }
+}
@@ -0,0 +1,264 @@
+/*
+
+SmallVector<N>: same interface as Vector but up to N elements are stored inside the object itself
+(small buffer optimization, like the SSO of std::string). Only bigger sizes go to the heap.
+
+Move semantics differ with the storage:
+ - heap storage: the move steals the pointer, O(1) like Vector
+ - inline storage: there is nothing to steal, the move has to copy the elements, O(N) like std::array
+
+1) g++ -std=c++17 -O2 -Wall -pedantic small_vector.cpp -o small_vector
+
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <stdexcept>
+#include <exception>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include <cassert>
+
+
+// 1. Vector from main.cpp (without the traces), used as reference in the benchmark
+
+class Vector{
+ private:
+    double* m_elem;
+    size_t m_sz;
+ public:
+    explicit Vector(size_t s):m_elem{new double[s]},m_sz{s} {}
+    ~Vector(){delete[] m_elem;}
+
+    Vector(const Vector& other):m_elem{new double[other.m_sz]},m_sz{other.m_sz} {
+        std::copy(other.m_elem, other.m_elem + m_sz, m_elem);
+    }
+    Vector& operator=(const Vector& other) {
+        if(this == &other) return *this;
+        delete[] m_elem;
+        m_elem = new double[other.m_sz];
+        std::copy(other.m_elem, other.m_elem + other.m_sz, m_elem);
+        m_sz = other.m_sz;
+        return *this;
+    }
+
+    Vector(Vector&& other) noexcept:m_elem{other.m_elem},m_sz{other.m_sz} {
+        other.m_elem = nullptr;
+        other.m_sz = 0;
+    }
+    Vector& operator=(Vector&& other) noexcept {
+        if (this == &other) return *this;
+        delete[] m_elem;
+        m_elem = other.m_elem;
+        m_sz = other.m_sz;
+        other.m_elem = nullptr;
+        other.m_sz = 0;
+        return *this;
+    }
+
+    double& operator[](int i) {
+        if (i < 0 || size() <= i) throw std::out_of_range{"Vector operator[]: index out of range"};
+        return m_elem[i];
+    }
+    const double& operator[](int i) const {
+        if (i < 0 || size() <= i) throw std::out_of_range{"Vector operator[]: index out of range"};
+        return m_elem[i];
+    }
+
+    int size() const {return m_sz;}
+};
+
+
+// 2. SmallVector: m_elem points either to m_inline or to a heap buffer
+
+template<size_t N>
+class SmallVector{
+ private:
+    double* m_elem;
+    size_t m_sz;
+    size_t m_cap;
+    double m_inline[N];
+
+    bool isInline() const {return m_elem == m_inline;}
+    void release() {if (!isInline()) delete[] m_elem;}
+ public:
+    explicit SmallVector(size_t s);
+    ~SmallVector(){release();}
+
+    SmallVector(const SmallVector& vec);
+    SmallVector& operator=(const SmallVector& vec);
+
+    SmallVector( SmallVector&& vec) noexcept;
+    SmallVector& operator=( SmallVector&& vec) noexcept;
+
+    double& operator[](int i);
+    const double& operator[](int i) const;
+
+    int size() const {return m_sz;}
+    size_t capacity() const {return m_cap;}
+    bool onHeap() const {return !isInline();}
+};
+
+template<size_t N>
+SmallVector<N>::SmallVector(size_t s)
+:m_elem{s <= N ? m_inline : new double[s]},m_sz{s},m_cap{std::max(s, N)}
+{
+}
+
+template<size_t N>
+SmallVector<N>::SmallVector(const SmallVector& other)
+:m_elem{other.m_sz <= N ? m_inline : new double[other.m_sz]},m_sz{other.m_sz},m_cap{std::max(other.m_sz, N)}
+{
+    std::copy(other.m_elem, other.m_elem + m_sz, m_elem);
+}
+
+template<size_t N>
+SmallVector<N>& SmallVector<N>::operator=(const SmallVector& other)
+{
+    if(this == &other) return *this;
+    if (m_cap < other.m_sz) {           // only reallocate if the current storage is too small
+        auto elem = new double[other.m_sz];
+        release();
+        m_elem = elem;
+        m_cap = other.m_sz;
+    }
+    std::copy(other.m_elem, other.m_elem + other.m_sz, m_elem);
+    m_sz = other.m_sz;
+    return *this;
+}
+
+template<size_t N>
+SmallVector<N>::SmallVector(SmallVector&& other) noexcept
+:m_elem{m_inline},m_sz{other.m_sz},m_cap{N}
+{
+    if (other.isInline()) {
+        std::copy(other.m_elem, other.m_elem + m_sz, m_inline); // nothing to steal: copy
+    }
+    else {
+        m_elem = other.m_elem;                                  // steal the heap buffer
+        m_cap = other.m_cap;
+        other.m_elem = other.m_inline;
+        other.m_cap = N;
+    }
+    other.m_sz = 0;
+}
+
+template<size_t N>
+SmallVector<N>& SmallVector<N>::operator=(SmallVector&& other) noexcept
+{
+    if (this == &other) return *this;
+    if (other.isInline()) {
+        // we already own at least N elements of storage, heap or inline: copy into it
+        std::copy(other.m_elem, other.m_elem + other.m_sz, m_elem);
+    }
+    else {
+        release();
+        m_elem = other.m_elem;
+        m_cap = other.m_cap;
+        other.m_elem = other.m_inline;
+        other.m_cap = N;
+    }
+    m_sz = other.m_sz;
+    other.m_sz = 0;
+    return *this;
+}
+
+template<size_t N>
+const double& SmallVector<N>::operator[](int i) const
+{
+    if (i < 0 || size() <= i)
+    {
+        throw std::out_of_range{"SmallVector operator[]: index out of range"};
+    }
+    return m_elem[i];
+}
+
+template<size_t N>
+double& SmallVector<N>::operator[](int i)
+{
+    if (i < 0 || size() <= i)
+    {
+        throw std::out_of_range{"SmallVector operator[]: index out of range"};
+    }
+    return m_elem[i];
+}
+
+template<size_t N>
+SmallVector<N> MakeSmallVectorNRVO()
+{
+    SmallVector<N> vec{2};
+    vec[0] = 1;
+    vec[1] = 2;
+    return vec;
+}
+
+
+// 3. Benchmark: create, copy, move and destroy
+
+double g_sink; // read the results so the work is not optimized away
+
+// tell the compiler the object escapes, otherwise it may remove the new/delete pair altogether (GCC/clang)
+template<typename V>
+void escape(V& vec) { asm volatile("" : : "g"(&vec) : "memory"); }
+
+template<typename V, typename F>
+double nsPerOp(size_t s, F&& op)
+{
+    constexpr size_t iterations = 2'000'000;
+    std::vector<V> pool;
+    pool.reserve(16);
+    for (int i = 0; i < 16; ++i) pool.emplace_back(s);
+    for (auto& vec : pool) {
+        for (int i = 0; i < vec.size(); ++i) vec[i] = i;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) op(pool[i % 16], pool[(i + 1) % 16]);
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / iterations;
+}
+
+template<typename V>
+void benchmark(const char* name, size_t s)
+{
+    auto create = nsPerOp<V>(s, [s](V&, V&) { V vec(s); escape(vec); });
+    auto copy = nsPerOp<V>(s, [](V& src, V&) { V vec{src}; escape(vec); g_sink += vec[0]; });
+    auto copyAssign = nsPerOp<V>(s, [](V& src, V& dst) { dst = src; g_sink += dst[0]; });
+    auto move = nsPerOp<V>(s, [](V& src, V& dst) { V vec{std::move(src)}; g_sink += vec[0]; src = std::move(vec); (void)dst; });
+    std::cout << std::setw(16) << name << std::setw(6) << s
+              << std::setw(12) << create << std::setw(12) << copy
+              << std::setw(12) << copyAssign << std::setw(12) << move << "\n";
+}
+
+int main()
+{
+    // 1. storage depends on the size
+    SmallVector<16> small(4);
+    SmallVector<16> big(100);
+    std::cout << "SmallVector<16> small(4): on heap " << std::boolalpha << small.onHeap() << "\n";
+    std::cout << "SmallVector<16> big(100): on heap " << big.onHeap() << "\n";
+
+    // 2. move of inline data copies, move of heap data steals
+    small[0] = 42;
+    SmallVector<16> small2 = std::move(small);
+    assert(!small2.onHeap() && small2[0] == 42);
+    big[0] = 7;
+    SmallVector<16> big2 = std::move(big);
+    assert(big2.onHeap() && big2[0] == 7 && big.size() == 0 && !big.onHeap());
+    big2 = std::move(small2);               // big2 keeps its heap buffer and copies into it
+    assert(big2.onHeap() && big2.size() == 4 && big2[0] == 42);
+    std::cout << "moves of inline (copy) and heap (steal) storage: ok\n";
+
+    auto nrvo = MakeSmallVectorNRVO<16>();  // same as MakeVectorNRVO, but no allocation at all
+    std::cout << "MakeSmallVectorNRVO: size " << nrvo.size() << " on heap " << nrvo.onHeap() << "\n\n";
+
+    // 3. benchmark in ns per operation
+    std::cout << "           class  size      create        copy copy assign   move x2\n";
+    for (size_t s : {2, 8, 16, 64}) {
+        benchmark<Vector>("Vector", s);
+        benchmark<SmallVector<16>>("SmallVector<16>", s);
+    }
+    std::cout << "(" << g_sink << ")\n";
+}
@@ -0,0 +1,124 @@
+/*
+
+TextCatalog: texts built once, interned and stored back to back in one single buffer.
+Displayers then only hold a view on it, constructing them costs no allocation and no string copy:
+ - std::string_view: the cheapest, valid as long as the catalogue lives
+ - TextSlice: string_view + shared_ptr on the catalogue, keeps it alive (one atomic increment per copy)
+
+LineBatch gathers many lines in a buffer and writes them in one call instead of one std::endl per line.
+
+C++17
+
+*/
+
+#ifndef TEXT_CATALOG_H
+#define TEXT_CATALOG_H
+
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class TextSlice;
+
+class TextCatalog : public std::enable_shared_from_this<TextCatalog> {
+ public:
+    class Builder {
+     public:
+        // same text added twice gets the same id and is stored only once
+        size_t add(std::string_view text) {
+            auto [iter, inserted] = m_ids.try_emplace(std::string{text}, m_entries.size());
+            if (inserted) {
+                m_entries.push_back({m_storage.size(), text.size()});
+                m_storage.append(text);
+            }
+            return iter->second;
+        }
+
+        std::shared_ptr<const TextCatalog> build() {
+            m_ids.clear();
+            return std::shared_ptr<const TextCatalog>{new TextCatalog{std::move(m_storage), std::move(m_entries)}};
+        }
+
+     private:
+        std::string m_storage;
+        std::vector<std::pair<size_t, size_t>> m_entries;        // offset, length
+        std::unordered_map<std::string, size_t> m_ids;           // only used while building
+    };
+
+    std::string_view operator[](size_t id) const {
+        if (id >= m_entries.size()) {
+            throw std::out_of_range{"TextCatalog: unknown text id"};
+        }
+        return std::string_view{m_storage}.substr(m_entries[id].first, m_entries[id].second);
+    }
+
+    TextSlice slice(size_t id) const;
+
+    size_t size() const { return m_entries.size(); }
+
+ private:
+    TextCatalog(std::string storage, std::vector<std::pair<size_t, size_t>> entries)
+    :m_storage{std::move(storage)},m_entries{std::move(entries)} {}
+
+    const std::string m_storage;    // never modified after build(): the views stay valid
+    const std::vector<std::pair<size_t, size_t>> m_entries;
+};
+
+class TextSlice {
+ public:
+    TextSlice(std::shared_ptr<const TextCatalog> owner, std::string_view view)
+    :m_owner{std::move(owner)},m_view{view} {}
+
+    operator std::string_view() const { return m_view; }
+    std::string_view view() const { return m_view; }
+
+ private:
+    std::shared_ptr<const TextCatalog> m_owner;
+    std::string_view m_view;
+};
+
+inline TextSlice TextCatalog::slice(size_t id) const
+{
+    return TextSlice{shared_from_this(), (*this)[id]};
+}
+
+inline std::ostream& operator<<(std::ostream& out, const TextSlice& slice)
+{
+    return out << slice.view();
+}
+
+class LineBatch {
+ public:
+    explicit LineBatch(std::ostream& out = std::cout, size_t capacity = 64 * 1024)
+    :m_out{out},m_capacity{capacity} { m_buffer.reserve(capacity); }
+
+    ~LineBatch() { flush(); }
+
+    LineBatch(const LineBatch&) = delete;
+    LineBatch& operator=(const LineBatch&) = delete;
+
+    void add(std::string_view line) {
+        if (m_buffer.size() + line.size() + 1 > m_capacity) flush();
+        m_buffer.append(line);
+        m_buffer += '\n';
+    }
+
+    void flush() {
+        if (m_buffer.empty()) return;
+        m_out.write(m_buffer.data(), m_buffer.size());
+        m_out.flush();
+        m_buffer.clear();   // keeps the capacity
+    }
+
+ private:
+    std::ostream& m_out;
+    size_t m_capacity;
+    std::string m_buffer;
+};
+
+#endif // TEXT_CATALOG_H
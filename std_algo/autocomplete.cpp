@@ -0,0 +1,143 @@
+/*
+
+Autocomplete over a dictionary of random words (default 1M), µs per prefix query by prefix length:
+ - equal_range: the code of binary_search.cpp, std::string::substr in the comparator (2 allocations per step)
+ - string_view: same equal_range, the comparator takes std::string_view (no allocation)
+ - PrefixIndex: range of the words, first 2 bytes from a table then binary search (prefix_index.h)
+ - scan top 10: equal_range on string_view then partial_sort of the scores of the whole range
+ - topK(10): PrefixIndex::topK, sparse table of the best scores
+
+Startup: the index is built, saved and opened again with mmap, the time to open does not depend on its size.
+
+1) g++ -std=c++17 -O2 -Wall -pedantic autocomplete.cpp -o autocomplete
+2) ./autocomplete 5000000    // dictionary of 5M words (default 1M)
+
+*/
+
+#include "prefix_index.h"
+#include "../common/bench.h"
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <algorithm>
+#include <random>
+#include <optional>
+#include <cassert>
+
+struct Dictionary {
+    std::vector<std::string> words;     // sorted, unique
+    std::vector<uint32_t> scores;       // score of words[i]
+};
+
+Dictionary makeDictionary(size_t size)
+{
+    std::mt19937 gen{42};
+    std::uniform_int_distribution<int> letter{'a', 'z'};
+    std::uniform_int_distribution<size_t> length{4, 12};
+    std::vector<std::string> words(size);
+    for (auto& word : words) {
+        word.resize(length(gen));
+        for (auto& c : word) c = static_cast<char>(letter(gen));
+    }
+    std::sort(words.begin(), words.end());
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+    Dictionary dico{std::move(words), {}};
+    std::uniform_int_distribution<uint32_t> score{0, 1'000'000};
+    for (size_t i = 0; i < dico.words.size(); ++i) dico.scores.push_back(score(gen));
+    return dico;
+}
+
+std::vector<std::pair<uint32_t, size_t>> scanTop(const Dictionary& dico, size_t first, size_t last, size_t k)
+{
+    std::vector<std::pair<uint32_t, size_t>> found;
+    for (size_t i = first; i < last; ++i) found.emplace_back(dico.scores[i], i);
+    k = std::min(k, found.size());
+    std::partial_sort(found.begin(), found.begin() + k, found.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.first > rhs.first || (lhs.first == rhs.first && lhs.second < rhs.second);
+    });
+    found.resize(k);
+    return found;
+}
+
+void benchmark(const Dictionary& dico, const PrefixIndex& index, size_t prefixLength)
+{
+    std::mt19937 gen{static_cast<unsigned>(prefixLength)};
+    std::uniform_int_distribution<size_t> pick{0, dico.words.size() - 1};
+    std::vector<std::string> prefixes(10'000);
+    for (auto& prefix : prefixes) prefix = dico.words[pick(gen)].substr(0, prefixLength);
+    const auto& words = dico.words;
+    const double perQuery = 1000.0 / prefixes.size();     // ms -> µs per query
+
+    size_t total = 0, viewTotal = 0, indexTotal = 0, scanScores = 0, topScores = 0;
+    const auto stringMs = bench::msFor([&] {
+        for (const auto& prefix : prefixes) {
+            auto [foundStart, foundEnd] = std::equal_range(words.begin(), words.end(), prefix, [n = prefix.size()](auto prevElem, auto nextElem){
+                return prevElem.substr(0,n) < nextElem.substr(0,n);
+            });
+            total += foundEnd - foundStart;
+        }
+    });
+    auto viewRange = [&words](std::string_view prefix) {
+        return std::equal_range(words.begin(), words.end(), prefix, [n = prefix.size()](std::string_view lhs, std::string_view rhs) {
+            return lhs.substr(0, n) < rhs.substr(0, n);
+        });
+    };
+    const auto viewMs = bench::msFor([&] {
+        for (const auto& prefix : prefixes) {
+            auto [foundStart, foundEnd] = viewRange(prefix);
+            viewTotal += foundEnd - foundStart;
+        }
+    });
+    const auto indexMs = bench::msFor([&] { for (const auto& prefix : prefixes) indexTotal += index.range(prefix).size(); });
+    const auto scanMs = bench::msFor([&] {
+        for (const auto& prefix : prefixes) {
+            auto [foundStart, foundEnd] = viewRange(prefix);
+            for (const auto& [score, i] : scanTop(dico, foundStart - words.begin(), foundEnd - words.begin(), 10)) scanScores += score;
+        }
+    });
+    const auto topMs = bench::msFor([&] {
+        for (const auto& prefix : prefixes) {
+            for (const auto& match : index.topK(prefix, 10)) topScores += match.score;
+        }
+    });
+    assert(viewTotal == total && indexTotal == total && topScores == scanScores);
+    bench::keep(total + topScores);
+
+    std::cout << std::setw(7) << prefixLength << std::setw(10) << total / prefixes.size()
+              << std::setw(13) << stringMs * perQuery << std::setw(13) << viewMs * perQuery
+              << std::setw(13) << indexMs * perQuery << std::setw(14) << scanMs * perQuery
+              << std::setw(11) << topMs * perQuery << "\n";
+}
+
+int main(int argc, char* argv[])
+{
+    // 1. dico of binary_search.cpp
+    PrefixIndex::Builder builder;
+    const std::vector<std::string> dico {"auto","circus","deque","doctor","dog","done","doom","door","enough"};
+    for (size_t i = 0; i < dico.size(); ++i) builder.add(dico[i], static_cast<uint32_t>(i % 4));
+    const auto small = builder.index();
+    for (auto word : small.complete("do")) std::cout << word << ":";
+    std::cout << "\nbest 3 for \"do\": ";
+    for (const auto& [word, score] : small.topK("do", 3)) std::cout << word << " (" << score << ") ";
+    std::cout << "\n\n";
+
+    // 2. startup
+    const size_t size = argc > 1 ? std::stoul(argv[1]) : 1'000'000;
+    const auto words = makeDictionary(size);
+    const std::string path = "/tmp/autocomplete.idx";
+    const double buildMs = bench::msFor([&] {
+        for (size_t i = 0; i < words.words.size(); ++i) builder.add(words.words[i], words.scores[i]);
+        builder.save(path);
+    });
+    std::optional<PrefixIndex> index;
+    const double openMs = bench::msFor([&] { index = PrefixIndex::open(path); });
+    std::cout << index->size() << " words: built and saved in " << buildMs << " ms, opened in " << openMs << " ms\n\n";
+
+    // 3. queries
+    std::cout << "                       equal_range                   PrefixIndex     scan      PrefixIndex\n";
+    std::cout << " prefix  matches    std::string  string_view      range        top 10      topK(10)  (µs/query)\n";
+    for (size_t length = 1; length <= 5; ++length) benchmark(words, *index, length);
+}
@@ -0,0 +1,95 @@
+/*
+
+Looking up a batch of 1M keys in one sorted int table, from 4KB (L1) to 256MB (DRAM), in millions of lookups
+per second:
+ - std::lower_bound: one key after the other
+ - branchless: search::lowerBound, one key after the other
+ - interleaved: search::lowerBounds, 16 branchless searches advance together and prefetch their next probe
+ - sorted sweep: search::lowerBounds with Batch::SortedSweep, sorting the keys included
+
+The interleaved searches keep up to 16 cache misses in flight instead of one or two: the bigger the table, the
+bigger the gain. The sweep pays the sort of the keys, it wins when there are many keys per element of the table.
+
+1) g++ -std=c++17 -O2 -Wall -pedantic batch_search.cpp -o batch_search
+2) ./batch_search 67108864    // from 1K up to 64M ints (default 16M)
+
+*/
+
+#include "search.h"
+#include "../common/bench.h"
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <cassert>
+
+template<typename F>
+double millionsPerSecond(size_t ops, F&& f)
+{
+    return 1e3 / bench::nsPerOp(ops, f);
+}
+
+size_t total(const std::vector<std::optional<size_t>>& results, size_t notFound)
+{
+    size_t sum = 0;
+    for (const auto& position : results) sum += position.value_or(notFound);
+    return sum;
+}
+
+void benchmark(size_t size, const std::vector<int>& keys)
+{
+    std::vector<int> sorted(size);
+    for (size_t i = 0; i < size; ++i) sorted[i] = static_cast<int>(2 * i + 1);
+
+    size_t expected = 0;
+    std::vector<std::optional<size_t>> results(keys.size());
+    const auto stdRate = millionsPerSecond(keys.size(), [&] {
+        for (int key : keys) expected += std::lower_bound(sorted.begin(), sorted.end(), key) - sorted.begin();
+    });
+    const auto branchlessRate = millionsPerSecond(keys.size(), [&] {
+        for (size_t i = 0; i < keys.size(); ++i) results[i] = search::lowerBound(sorted, keys[i]);
+    });
+    assert(total(results, size) == expected);
+    const auto interleavedRate = millionsPerSecond(keys.size(), [&] {
+        search::lowerBounds(sorted.data(), size, keys.data(), keys.size(), results.data());
+    });
+    assert(total(results, size) == expected);
+    const auto sweepRate = millionsPerSecond(keys.size(), [&] {
+        search::lowerBounds(sorted.data(), size, keys.data(), keys.size(), results.data(), search::Batch::SortedSweep);
+    });
+    assert(total(results, size) == expected);
+    bench::keep(expected);
+
+    std::cout << std::setw(10) << size << std::setw(10) << size * sizeof(int) / 1024 << "KB"
+              << std::setw(18) << stdRate << std::setw(12) << branchlessRate << std::setw(13) << interleavedRate
+              << std::setw(14) << sweepRate << "\n";
+}
+
+int main(int argc, char* argv[])
+{
+    // 1. one std::optional per key, in the order of the keys
+    const std::vector<int> v4 {0, 1, 2, 3, 4, 5, 6, 7, 8};
+    const std::vector<int> keys {8, -1, 9, 4};
+    for (auto mode : {search::Batch::Interleaved, search::Batch::SortedSweep}) {
+        for (const auto& position : search::lowerBounds(v4, keys, mode)) {
+            if (position) std::cout << v4[*position] << " at " << *position << ", ";
+            else std::cout << "none, ";
+        }
+        std::cout << "\n";
+    }
+    std::cout << "\n";
+
+    // 2. benchmark
+    const size_t maxSize = argc > 1 ? std::stoul(argv[1]) : 16 * 1024 * 1024;
+    std::mt19937 gen{42};
+    std::vector<int> batch(1'000'000);
+
+    std::cout << "      size      bytes  std::lower_bound  branchless  interleaved  sorted sweep  (M lookups/s)\n";
+    for (size_t size = 1024; size <= maxSize; size *= 4) {
+        std::uniform_int_distribution<int> dist{0, static_cast<int>(2 * size + 1)};
+        for (auto& key : batch) key = dist(gen);
+        benchmark(size, batch);
+    }
+}
@@ -1,33 +1,14 @@
 #include <string>
+#include <string_view>
 #include <iostream>
 #include <algorithm>
 #include <vector>
 #include <optional>
+
+#include "search.h"
    
    
-// 2. Binary search O(log(n))
-
-template<typename T, typename K>
-const typename T::iterator binarySearch(T& seq, const K elem) {
-    auto first = seq.begin();
-    auto last = seq.end();
-    if (elem < *first || elem > *std::prev(last)) return seq.end();
-
-    while (first < last) {
-        auto const N = std::distance(first, last);
-        auto const pivot = std::next(first, N / 2);
-        if (elem == *pivot) {
-            return (pivot);
-        }
-        else if (elem < *pivot) {
-            last = pivot;
-        }
-        else {
-            first = pivot;
-        }
-    }
-    return seq.end();
-}
+// 2. Binary search O(log(n)): search::binarySearch of search.h
 
 int main() {
 
@@ -36,7 +17,7 @@ int main() {
 
     //1. Binary search using std::lower_bound and not
     std::cout << "\n";
-    if (std::vector<int>::iterator position = binarySearch(v4, 7); position != v4.end()) {
+    if (std::vector<int>::iterator position = search::binarySearch(v4, 7); position != v4.end()) {
         std::cout << "found at pos :" << *position << "\n";
     }
 
@@ -44,13 +25,24 @@ int main() {
         std::cout << "found at pos using lower bound :" << *position << "\n";
     }
 
+    // lower bound on the layouts of search.h (search.cpp for the benchmark), std::nullopt if every element is smaller
+    const search::Eytzinger<int> layout{v4};
+    if (auto position = layout.lowerBound(5)) {
+        std::cout << "found at pos using Eytzinger :" << *position << "\n";
+    }
+    for (int elem : {-1, 0, 4, 8, 9}) {
+        if (search::binarySearch(v4, elem) != v4.end()) std::cout << elem << " found, ";
+    }
+    std::cout << "\n";
+
     //2. example of auto completion, searching a prefix using std::equal_range
     std::vector<std::string> dico {"auto","circus","deque","doctor","dog","done","doom","door","enough"};
     const std::string prefix {"do"};
-    auto [foundStart, foundEnd] = std::equal_range(dico.begin(), dico.end(), prefix, [n = prefix.size()](auto prevElem, auto nextElem){
+    // string_view: substr makes no copy (on std::string, 2 strings allocated per comparison). See prefix_index.h
+    auto [foundStart, foundEnd] = std::equal_range(dico.begin(), dico.end(), prefix, [n = prefix.size()](std::string_view prevElem, std::string_view nextElem){
         return prevElem.substr(0,n) < nextElem.substr(0,n);
     });
-    if(foundStart != dico.end() && foundEnd != dico.end()){
+    if(foundStart != foundEnd){
        for_each(foundStart, foundEnd, [](const auto & elem){ std::cout << elem <<":";}); 
     }
 
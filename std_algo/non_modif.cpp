@@ -3,15 +3,18 @@
 #include <vector>
 #include <algorithm>
 #include <functional>
+#include "../common/out_sink.h"
 
 
 template<typename T>
-void display(T cont){
-    std::cout << "{";
+void display(const T& cont){
+    auto& out = output::stdoutSink();
+    out << "{";
     for (const auto& elem : cont) {
-        std::cout << elem << ",";
+        out << elem << ",";
     }
-    std::cout << "}\n";
+    out << "}\n";
+    out.flush();
 }
 struct People {
     std::string name;
@@ -36,7 +39,7 @@ int main() {
     auto v1 = std::vector{0,1,2,3,4,5,6,7,8};
     display(v1);
 
-    // 1. Non-Modifying Sequence Operation
+    // 1. Non-Modifying Sequence Operation (on all the cores with an early exit: parallel_find.h)
     // 1.1 use find_if to find the 1st odd element
     auto firstOdd = std::find_if(v1.cbegin(), v1.cend(), [&v1](const auto &elem) {
         return ((elem % 2) == 1);
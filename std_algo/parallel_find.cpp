@@ -0,0 +1,117 @@
+/*
+
+The searches of non_modif.cpp on 100M int, serial std:: against parallel_find.h with 1, 2, 4... threads up to the
+number of cores (or the second argument), ms. The match is near the start (position 1000), in the middle, or absent:
+ - find_if / any_of: first negative element, all_of: all elements positive
+ - mismatch / equal: v against a copy of v, one element modified
+ - search: a sequence of 8 elements
+
+1) g++ -std=c++17 -O2 -Wall -pedantic parallel_find.cpp -o parallel_find -pthread
+2) ./parallel_find 200000000 8    // 200M int, from 1 up to 8 threads (default 100M, all the cores)
+
+*/
+
+#include "parallel_find.h"
+#include "../common/bench.h"
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <random>
+#include <cassert>
+
+struct Data {
+    std::vector<int> v;
+    std::vector<int> v2;    // copy of v, modified at the match
+    std::vector<int> seq;   // stored in v at the match
+};
+
+// runs the std:: version and the parallel version on each pool, checks they give the same result
+template<typename Serial, typename Parallel>
+void benchmark(const char* name, const char* where, const std::vector<std::unique_ptr<parallel::WorkStealingPool>>& pools,
+               Serial serial, Parallel parallelRun)
+{
+    decltype(serial()) expected;
+    std::cout << std::fixed << std::setprecision(2) << std::setw(9) << name << std::setw(8) << where << std::setw(10) << bench::msFor([&] { expected = serial(); });
+    for (const auto& pool : pools) {
+        decltype(serial()) result;
+        std::cout << std::setw(10) << bench::msFor([&] { result = parallelRun(parallel::Policy{pool.get()}); });
+        assert(result == expected);
+    }
+    std::cout << "\n";
+}
+
+void benchmarkAll(Data& data, const char* where, const std::vector<std::unique_ptr<parallel::WorkStealingPool>>& pools)
+{
+    const auto& v = data.v;
+    const auto& v2 = data.v2;
+    const auto& seq = data.seq;
+    auto negative = [](int elem) { return elem < 0; };
+    auto positive = [](int elem) { return elem >= 0; };
+    auto position = [&v](auto it) { return it - v.begin(); };
+
+    benchmark("find_if", where, pools, [&] { return position(std::find_if(v.begin(), v.end(), negative)); },
+              [&](const auto& policy) { return position(parallel::findIf(policy, v.begin(), v.end(), negative)); });
+    benchmark("any_of", where, pools, [&] { return std::any_of(v.begin(), v.end(), negative); },
+              [&](const auto& policy) { return parallel::anyOf(policy, v.begin(), v.end(), negative); });
+    benchmark("all_of", where, pools, [&] { return std::all_of(v.begin(), v.end(), positive); },
+              [&](const auto& policy) { return parallel::allOf(policy, v.begin(), v.end(), positive); });
+    benchmark("mismatch", where, pools, [&] { return position(std::mismatch(v.begin(), v.end(), v2.begin()).first); },
+              [&](const auto& policy) { return position(parallel::mismatch(policy, v.begin(), v.end(), v2.begin()).first); });
+    benchmark("equal", where, pools, [&] { return std::equal(v.begin(), v.end(), v2.begin()); },
+              [&](const auto& policy) { return parallel::equal(policy, v.begin(), v.end(), v2.begin()); });
+    benchmark("search", where, pools, [&] { return position(std::search(v.begin(), v.end(), seq.begin(), seq.end())); },
+              [&](const auto& policy) { return position(parallel::search(policy, v.begin(), v.end(), seq.begin(), seq.end())); });
+}
+
+int main(int argc, char* argv[])
+{
+    // 1. v1 of non_modif.cpp
+    parallel::WorkStealingPool small{2};
+    const parallel::Policy policy{&small, 0};     // parallel even on 9 elements
+    auto v1 = std::vector{0,1,2,3,4,5,6,7,8};
+    auto v2{v1};
+    v2[3] += 10;
+    auto firstOdd = parallel::findIf(policy, v1.cbegin(), v1.cend(), [](const auto& elem) { return elem % 2 == 1; });
+    auto [mismatchV1, mismatchV2] = parallel::mismatch(policy, v1.begin(), v1.end(), v2.begin());
+    auto seq = std::vector{4,5,6};
+    auto foundSeq = parallel::search(policy, v1.begin(), v1.end(), seq.begin(), seq.end());
+    std::cout << "1st odd: " << *firstOdd << ", contains 7: " << std::boolalpha
+              << parallel::anyOf(policy, v1.begin(), v1.end(), [](int elem) { return elem == 7; })
+              << ", mismatch: " << *mismatchV1 << " " << *mismatchV2 << ", found seq at " << foundSeq - v1.begin() << "\n\n";
+
+    // 2. benchmark
+    const size_t size = argc > 1 ? std::stoul(argv[1]) : 100'000'000;
+    const unsigned maxThreads = argc > 2 ? std::stoul(argv[2]) : parallel::defaultThreads();
+    std::vector<std::unique_ptr<parallel::WorkStealingPool>> pools;
+    std::cout << "           match       std";
+    for (unsigned threads = 1; threads <= maxThreads; threads = threads < maxThreads ? std::min(2 * threads, maxThreads) : threads + 1) {
+        pools.push_back(std::make_unique<parallel::WorkStealingPool>(threads));
+        std::cout << std::setw(6) << threads << " thr";
+    }
+    std::cout << "  (ms)\n";
+
+    Data data;
+    std::mt19937 gen{42};
+    std::uniform_int_distribution<int> values{0, 1'000'000};
+    data.v.resize(size);
+    for (auto& elem : data.v) elem = values(gen);
+    data.seq = {-1, -2, -3, -4, -5, -6, -7, -8};
+    data.v2.reserve(size);
+
+    for (const auto& [where, position] : {std::pair{"start", size_t{1000}}, std::pair{"middle", size / 2}, std::pair{"absent", size}}) {
+        const bool found = position + data.seq.size() <= size;
+        std::vector<int> saved;
+        if (found) {
+            saved.assign(data.v.begin() + position, data.v.begin() + position + data.seq.size());
+            std::copy(data.seq.begin(), data.seq.end(), data.v.begin() + position);
+        }
+        data.v2 = data.v;
+        if (found) data.v2[position] = 0;
+        benchmarkAll(data, where, pools);
+        if (found) std::copy(saved.begin(), saved.end(), data.v.begin() + position);
+    }
+}
@@ -0,0 +1,184 @@
+/*
+
+The non-modifying algorithms of non_modif.cpp on all the cores, with an early exit:
+
+    parallel::WorkStealingPool pool{parallel::defaultThreads()};
+    const parallel::Policy policy{&pool};
+    auto firstOdd = parallel::findIf(policy, v1.begin(), v1.end(), [](int elem) { return elem % 2 == 1; });
+    bool has7 = parallel::anyOf(policy, v1.begin(), v1.end(), [](int elem) { return elem == 7; });
+    auto [mismatchV1, mismatchV2] = parallel::mismatch(policy, v1.begin(), v1.end(), v2.begin());
+    auto found = parallel::search(policy, v1.begin(), v1.end(), seq.begin(), seq.end());
+
+findIf, find, anyOf, allOf, noneOf, mismatch, equal and search, random access iterators only. The range is split
+into 4 chunks per thread of the pool, each chunk is scanned block by block (kFindBlock elements) with the serial
+std:: algorithm. All the chunks share the position of the best match found so far (an atomic, lowered with
+compare_exchange):
+ - findIf, mismatch, search return the first match like the serial version: a chunk stops before a block which
+   starts after a match already found, the chunks before it still finish their scan
+ - anyOf, allOf, noneOf, equal only need one match: every chunk stops at its next block once any match is found
+Below Policy::serialBelow elements (or without a pool, or with a pool of 1 thread) the serial std:: algorithm runs.
+
+C++17
+
+*/
+
+#ifndef PARALLEL_FIND_H
+#define PARALLEL_FIND_H
+
+#include "parallel_sort.h"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+namespace parallel {
+
+constexpr size_t kSerialFind = 1 << 15;     // default Policy::serialBelow
+constexpr size_t kFindBlock = 1 << 14;      // elements between 2 checks of the best match
+
+struct Policy {
+    WorkStealingPool* pool = nullptr;
+    size_t serialBelow = kSerialFind;       // below: the serial algorithm, tuned per use
+};
+
+namespace detail {
+
+template<typename It>
+constexpr bool isRandomAccess = std::is_base_of_v<std::random_access_iterator_tag, typename std::iterator_traits<It>::iterator_category>;
+
+// findInBlock(begin, end) returns the first match in [begin, end) of the positions of the range, or end.
+// Returns the first match of the whole range (anyMatch: any match, the first one found), or size
+template<typename FindInBlock>
+size_t findFirst(const Policy& policy, size_t size, bool anyMatch, FindInBlock findInBlock)
+{
+    if (policy.pool == nullptr || policy.pool->threads() == 1 || size < std::max<size_t>(policy.serialBelow, 1)) {
+        return findInBlock(size_t{0}, size);
+    }
+    const size_t chunks = std::max<size_t>(1, std::min(policy.pool->threads() * 4, size / kFindBlock));
+    std::atomic<size_t> best{size};
+    forChunks(*policy.pool, size, chunks, [&](size_t, size_t first, size_t last) {
+        for (size_t begin = first; begin < last; begin += kFindBlock) {
+            const size_t found = best.load(std::memory_order_relaxed);
+            if (anyMatch ? found != size : found < begin) return;
+            const size_t end = std::min(begin + kFindBlock, last);
+            const size_t match = findInBlock(begin, end);
+            if (match == end) continue;
+            size_t current = best.load(std::memory_order_relaxed);
+            while (match < current && !best.compare_exchange_weak(current, match, std::memory_order_relaxed)) {}
+            return;
+        }
+    });
+    return best.load();
+}
+
+} // namespace detail
+
+
+// 1. find
+
+template<typename RandomIt, typename Pred>
+RandomIt findIf(const Policy& policy, RandomIt first, RandomIt last, Pred pred)
+{
+    static_assert(detail::isRandomAccess<RandomIt>, "parallel::findIf: random access iterators only");
+    const size_t size = static_cast<size_t>(last - first);
+    return first + detail::findFirst(policy, size, false, [first, &pred](size_t begin, size_t end) {
+        return static_cast<size_t>(std::find_if(first + begin, first + end, pred) - first);
+    });
+}
+
+template<typename RandomIt, typename T>
+RandomIt find(const Policy& policy, RandomIt first, RandomIt last, const T& value)
+{
+    return findIf(policy, first, last, [&value](const auto& elem) { return elem == value; });
+}
+
+
+// 2. anyOf, allOf, noneOf: stop at any match
+
+template<typename RandomIt, typename Pred>
+bool anyOf(const Policy& policy, RandomIt first, RandomIt last, Pred pred)
+{
+    static_assert(detail::isRandomAccess<RandomIt>, "parallel::anyOf: random access iterators only");
+    const size_t size = static_cast<size_t>(last - first);
+    return detail::findFirst(policy, size, true, [first, &pred](size_t begin, size_t end) {
+        return static_cast<size_t>(std::find_if(first + begin, first + end, pred) - first);
+    }) != size;
+}
+
+template<typename RandomIt, typename Pred>
+bool noneOf(const Policy& policy, RandomIt first, RandomIt last, Pred pred)
+{
+    return !anyOf(policy, first, last, pred);
+}
+
+template<typename RandomIt, typename Pred>
+bool allOf(const Policy& policy, RandomIt first, RandomIt last, Pred pred)
+{
+    return !anyOf(policy, first, last, std::not_fn(pred));
+}
+
+
+// 3. mismatch, equal
+
+template<typename RandomIt1, typename RandomIt2, typename BinaryPred = std::equal_to<>>
+std::pair<RandomIt1, RandomIt2> mismatch(const Policy& policy, RandomIt1 first1, RandomIt1 last1, RandomIt2 first2, BinaryPred pred = BinaryPred{})
+{
+    static_assert(detail::isRandomAccess<RandomIt1> && detail::isRandomAccess<RandomIt2>, "parallel::mismatch: random access iterators only");
+    const size_t size = static_cast<size_t>(last1 - first1);
+    const size_t position = detail::findFirst(policy, size, false, [first1, first2, &pred](size_t begin, size_t end) {
+        return static_cast<size_t>(std::mismatch(first1 + begin, first1 + end, first2 + begin, pred).first - first1);
+    });
+    return {first1 + position, first2 + position};
+}
+
+// up to the end of the shorter range
+template<typename RandomIt1, typename RandomIt2, typename BinaryPred = std::equal_to<>>
+std::pair<RandomIt1, RandomIt2> mismatch(const Policy& policy, RandomIt1 first1, RandomIt1 last1, RandomIt2 first2, RandomIt2 last2, BinaryPred pred = BinaryPred{})
+{
+    const auto size = std::min<std::ptrdiff_t>(last1 - first1, last2 - first2);
+    return mismatch(policy, first1, first1 + size, first2, pred);
+}
+
+template<typename RandomIt1, typename RandomIt2, typename BinaryPred = std::equal_to<>>
+bool equal(const Policy& policy, RandomIt1 first1, RandomIt1 last1, RandomIt2 first2, BinaryPred pred = BinaryPred{})
+{
+    static_assert(detail::isRandomAccess<RandomIt1> && detail::isRandomAccess<RandomIt2>, "parallel::equal: random access iterators only");
+    const size_t size = static_cast<size_t>(last1 - first1);
+    // any position in the block is enough: without predicate std::equal compares with memcmp when it can
+    return detail::findFirst(policy, size, true, [first1, first2, &pred](size_t begin, size_t end) {
+        if constexpr (std::is_same_v<BinaryPred, std::equal_to<>>) return std::equal(first1 + begin, first1 + end, first2 + begin) ? end : begin;
+        else return std::equal(first1 + begin, first1 + end, first2 + begin, pred) ? end : begin;
+    }) == size;
+}
+
+template<typename RandomIt1, typename RandomIt2, typename BinaryPred = std::equal_to<>>
+bool equal(const Policy& policy, RandomIt1 first1, RandomIt1 last1, RandomIt2 first2, RandomIt2 last2, BinaryPred pred = BinaryPred{})
+{
+    return last1 - first1 == last2 - first2 && equal(policy, first1, last1, first2, pred);
+}
+
+
+// 4. search: each block looks for the sequences which start in it, reading up to size of seq - 1 elements after it
+
+template<typename RandomIt1, typename RandomIt2, typename BinaryPred = std::equal_to<>>
+RandomIt1 search(const Policy& policy, RandomIt1 first, RandomIt1 last, RandomIt2 seqFirst, RandomIt2 seqLast, BinaryPred pred = BinaryPred{})
+{
+    static_assert(detail::isRandomAccess<RandomIt1> && detail::isRandomAccess<RandomIt2>, "parallel::search: random access iterators only");
+    const size_t seqSize = static_cast<size_t>(seqLast - seqFirst);
+    const size_t size = static_cast<size_t>(last - first);
+    if (seqSize == 0) return first;
+    if (seqSize > size) return last;
+    const size_t starts = size - seqSize + 1;
+    const size_t position = detail::findFirst(policy, starts, false, [&](size_t begin, size_t end) {
+        const auto found = std::search(first + begin, first + end + seqSize - 1, seqFirst, seqLast, pred);
+        return std::min(static_cast<size_t>(found - first), end);
+    });
+    return position == starts ? last : first + position;
+}
+
+} // namespace parallel
+
+#endif // PARALLEL_FIND_H
@@ -0,0 +1,106 @@
+/*
+
+Sorting millions of People of reorder.cpp (random names of 8 letters, ages from 0 to 99), ms:
+ - by name: quickSort of reorder.cpp (nth_element), std::sort, parallel::sort
+ - by age, stable: std::stable_sort, parallel::stableSort, parallel::radixSort
+parallel::* run with 1, 2, 4... threads up to the number of cores (or the second argument).
+
+1) g++ -std=c++17 -O2 -Wall -pedantic parallel_sort.cpp -o parallel_sort -pthread
+2) ./parallel_sort 10000000 8    // 10M people, from 1 up to 8 threads (default 4M, all the cores)
+
+*/
+
+#include "parallel_sort.h"
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <chrono>
+#include <cassert>
+
+struct People {
+    std::string name;
+    int age;
+};
+
+bool operator<(const People& lhs, const People& rhs) {
+    return lhs.age < rhs.age;
+}
+
+bool operator==(const People& lhs, const People& rhs) {
+    return lhs.name == rhs.name && lhs.age == rhs.age;
+}
+
+// same as reorder.cpp
+template<typename FwdIt, typename Compare = std::less<>>
+void quickSort(FwdIt first, FwdIt last, Compare cmp = Compare{}) {
+    auto const N = std::distance(first, last);
+    if (N <= 1) return;
+    auto const pivot = std::next(first, N / 2);
+    std::nth_element(first, pivot, last, cmp);
+    quickSort(first, pivot, cmp);
+    quickSort(pivot, last, cmp);
+}
+
+template<typename F>
+double msFor(std::vector<People> record, F&& sort)
+{
+    auto start = std::chrono::steady_clock::now();
+    sort(record);
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+int main(int argc, char* argv[])
+{
+    auto byName = [](const People& lhs, const People& rhs) { return lhs.name < rhs.name; };
+    auto age = [](const People& people) { return people.age; };
+
+    // 1. record of reorder.cpp
+    std::vector<People> record = {{"Cathy", 59},{"Rene", 99},{"Elon", 53},{"Leon", 13},{"Arthur", 99},{"Anna", 43}};
+    parallel::radixSort(record.begin(), record.end(), age);
+    for (const auto& [name, age] : record) std::cout << "[ " << name << ":" << age << " ]";
+    std::cout << "\n";
+
+    // 2. same result as the standard sorts
+    const size_t size = argc > 1 ? std::stoul(argv[1]) : 4'000'000;
+    const unsigned maxThreads = argc > 2 ? std::stoul(argv[2]) : parallel::defaultThreads();
+    std::mt19937 gen{42};
+    std::uniform_int_distribution<int> letter{'a', 'z'};
+    std::uniform_int_distribution<int> years{0, 99};
+    std::vector<People> people(size);
+    for (auto& [name, age] : people) {
+        name.resize(8);
+        for (auto& c : name) c = static_cast<char>(letter(gen));
+        age = years(gen);
+    }
+    {
+        auto byAge = people;
+        std::stable_sort(byAge.begin(), byAge.end());
+        auto sorted = people;
+        parallel::stableSort(sorted.begin(), sorted.end(), std::less<>{}, maxThreads);
+        assert(sorted == byAge);
+        sorted = people;
+        parallel::radixSort(sorted.begin(), sorted.end(), age, maxThreads);
+        assert(sorted == byAge);
+        sorted = people;
+        parallel::sort(sorted.begin(), sorted.end(), byName, maxThreads);
+        assert(std::is_sorted(sorted.begin(), sorted.end(), byName));
+    }
+
+    // 3. benchmark
+    std::cout << "\nms to sort " << size << " people\n";
+    std::cout << "by name:  quickSort " << msFor(people, [&](auto& v) { quickSort(v.begin(), v.end(), byName); })
+              << "  std::sort " << msFor(people, [&](auto& v) { std::sort(v.begin(), v.end(), byName); }) << "\n";
+    std::cout << "by age:   std::stable_sort " << msFor(people, [](auto& v) { std::stable_sort(v.begin(), v.end()); }) << "\n\n";
+    std::cout << " threads  parallel::sort  parallel::stableSort  parallel::radixSort\n";
+    for (unsigned threads = 1; threads <= maxThreads; threads = threads < maxThreads ? std::min(2 * threads, maxThreads) : threads + 1) {
+        std::cout << std::setw(8) << threads
+                  << std::setw(16) << msFor(people, [&](auto& v) { parallel::sort(v.begin(), v.end(), byName, threads); })
+                  << std::setw(22) << msFor(people, [&](auto& v) { parallel::stableSort(v.begin(), v.end(), std::less<>{}, threads); })
+                  << std::setw(21) << msFor(people, [&](auto& v) { parallel::radixSort(v.begin(), v.end(), age, threads); }) << "\n";
+    }
+}
@@ -0,0 +1,402 @@
+/*
+
+Sorting on all the cores, same iterator + comparator signature as quickSort of reorder.cpp:
+
+    parallel::sort(record.begin(), record.end(), [](const auto& lhs, const auto& rhs){ return lhs.name < rhs.name; });
+    parallel::stableSort(record.begin(), record.end(), byAge);
+    parallel::radixSort(record.begin(), record.end(), [](const People& p) { return p.age; });
+
+sort / stableSort: sample sort. A sorted sample of the range gives up to 127 splitters (kMaxBuckets / 2 - 1),
+every element is then moved into the bucket between its 2 splitters (up to 255 buckets, stored one after the other),
+and each bucket is sorted the same way as a separate task, down to kSerialCutoff elements where std::sort /
+std::stable_sort take over (insertion sort below kInsertionCutoff). The elements equal to a splitter get their own bucket, already sorted:
+many equal keys (the ages of millions of people) never end in one huge bucket.
+The elements are moved in the order of the range, so stableSort only needs stable leaves.
+
+radixSort: LSD radix sort on an integer key, 8 bits per pass, stable. One pass counts all the digits, the passes
+where all the elements have the same digit are skipped: ages from 0 to 255 cost one single pass. With more than
+one chunk, the passes after the first one count their digit again on the new order of the elements (with one
+chunk the totals of the first count stay right).
+The elements go back and forth between the range and a buffer: contiguous iterators only (vector, array).
+
+The tasks run on a WorkStealingPool: each thread pops the last task of its own queue (the most recent, the data is
+still in cache) and when it is empty steals the first task of another queue (the oldest, the biggest bucket).
+The thread that calls sort works too: threads = 1 is the serial version.
+The elements are moved to a buffer and back: they must be default constructible and move assignable.
+
+C++17
+
+*/
+
+#ifndef PARALLEL_SORT_H
+#define PARALLEL_SORT_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace parallel {
+
+constexpr size_t kSerialCutoff = 1 << 14;       // below: one task sorts the whole bucket
+constexpr size_t kInsertionCutoff = 16;
+constexpr size_t kMaxBuckets = 256;
+constexpr size_t kOversampling = 16;            // samples per bucket
+constexpr size_t kParallelPass = 1 << 17;       // below: classification or radix pass in one chunk
+
+inline unsigned defaultThreads()
+{
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+
+// 1. Work stealing pool
+
+class WorkStealingPool {
+ public:
+    using Pending = std::atomic<size_t>;
+
+    // threads - 1 workers: the thread calling wait() is the last one
+    explicit WorkStealingPool(unsigned threads):m_queues(std::max(1u, threads)) {
+        for (auto& queue : m_queues) queue = std::make_unique<Queue>();
+        for (size_t i = 1; i < m_queues.size(); ++i) m_workers.emplace_back([this, i] { work(i); });
+    }
+
+    ~WorkStealingPool() {
+        {
+            std::lock_guard<std::mutex> lock{m_sleepMutex};
+            m_stop = true;
+        }
+        m_wake.notify_all();
+        for (auto& worker : m_workers) worker.join();
+    }
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    size_t threads() const { return m_queues.size(); }
+
+    // pending is decremented once the task has run
+    void submit(std::function<void()> task, Pending& pending) {
+        pending.fetch_add(1);
+        Queue& queue = *m_queues[t_pool == this ? t_index : 0];
+        {
+            std::lock_guard<std::mutex> lock{queue.mutex};
+            queue.tasks.push_back({std::move(task), &pending});
+        }
+        m_queued.fetch_add(1);
+        m_wake.notify_one();
+    }
+
+    // runs tasks (from any queue) until pending is 0: a task can wait for the tasks it submitted
+    void wait(Pending& pending) {
+        const size_t self = t_pool == this ? t_index : 0;
+        while (pending.load() > 0) {
+            if (!runOne(self)) std::this_thread::yield();
+        }
+    }
+
+ private:
+    struct Task {
+        std::function<void()> run;
+        Pending* pending;
+    };
+
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    bool runOne(size_t self) {
+        Task task;
+        if (!pop(self, task)) return false;
+        WorkStealingPool* const previousPool = t_pool;
+        const size_t previousIndex = t_index;
+        t_pool = this;
+        t_index = self;
+        task.run();
+        t_pool = previousPool;
+        t_index = previousIndex;
+        task.pending->fetch_sub(1);
+        return true;
+    }
+
+    // own queue from the back, the others from the front
+    bool pop(size_t self, Task& task) {
+        if (m_queued.load() == 0) return false;
+        for (size_t i = 0; i < m_queues.size(); ++i) {
+            Queue& queue = *m_queues[(self + i) % m_queues.size()];
+            std::lock_guard<std::mutex> lock{queue.mutex};
+            if (queue.tasks.empty()) continue;
+            if (i == 0) {
+                task = std::move(queue.tasks.back());
+                queue.tasks.pop_back();
+            }
+            else {
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+            }
+            m_queued.fetch_sub(1);
+            return true;
+        }
+        return false;
+    }
+
+    void work(size_t self) {
+        while (true) {
+            if (runOne(self)) continue;
+            std::unique_lock<std::mutex> lock{m_sleepMutex};
+            if (m_stop) return;
+            // a task submitted between pop() and wait_for() is found at the next timeout at the latest
+            m_wake.wait_for(lock, std::chrono::milliseconds{1}, [this] { return m_stop || m_queued.load() > 0; });
+        }
+    }
+
+    std::vector<std::unique_ptr<Queue>> m_queues;   // 0: the thread outside of the pool
+    std::vector<std::thread> m_workers;
+    std::atomic<size_t> m_queued{0};
+    std::mutex m_sleepMutex;
+    std::condition_variable m_wake;
+    bool m_stop = false;
+
+    static inline thread_local WorkStealingPool* t_pool = nullptr;
+    static inline thread_local size_t t_index = 0;
+};
+
+// f(chunk, first, last) on [0, size) split in chunks, on the pool, returns once all are done
+template<typename F>
+void forChunks(WorkStealingPool& pool, size_t size, size_t chunks, F&& f)
+{
+    WorkStealingPool::Pending pending{0};
+    for (size_t chunk = 1; chunk < chunks; ++chunk) {
+        pool.submit([&f, chunk, size, chunks] { f(chunk, chunk * size / chunks, (chunk + 1) * size / chunks); }, pending);
+    }
+    f(0, 0, size / chunks);
+    pool.wait(pending);
+}
+
+inline size_t chunksFor(const WorkStealingPool& pool, size_t size)
+{
+    return size < kParallelPass ? 1 : std::min(pool.threads() * 4, size / (kParallelPass / 4));
+}
+
+
+// 2. Sample sort
+
+namespace detail {
+
+template<typename RandomIt, typename Compare>
+void insertionSort(RandomIt first, RandomIt last, Compare cmp)
+{
+    for (auto it = first; it != last; ++it) {
+        auto value = std::move(*it);
+        auto hole = it;
+        for (; hole != first && cmp(value, *std::prev(hole)); --hole) *hole = std::move(*std::prev(hole));
+        *hole = std::move(value);
+    }
+}
+
+template<bool Stable, typename RandomIt, typename Compare>
+void sortLeaf(RandomIt first, RandomIt last, Compare cmp)
+{
+    if (static_cast<size_t>(last - first) <= kInsertionCutoff) insertionSort(first, last, cmp);
+    else if constexpr (Stable) std::stable_sort(first, last, cmp);
+    else std::sort(first, last, cmp);
+}
+
+template<bool Stable, typename RandomIt, typename Compare>
+class SampleSort {
+ public:
+    using Value = typename std::iterator_traits<RandomIt>::value_type;
+
+    SampleSort(WorkStealingPool& pool, RandomIt first, Compare cmp, Value* buffer)
+    :m_pool{pool},m_first{first},m_cmp{cmp},m_buffer{buffer} {}
+
+    // [begin, end): positions in the whole range, the same positions of the buffer are free to use
+    void sort(size_t begin, size_t end, WorkStealingPool::Pending& pending) {
+        const size_t size = end - begin;
+        if (size <= kSerialCutoff) {
+            sortLeaf<Stable>(m_first + begin, m_first + end, m_cmp);
+            return;
+        }
+        const auto splitters = sampleSplitters(begin, end);
+        const size_t buckets = 2 * splitters.size() + 1;      // odd: equal to splitter (i - 1) / 2
+
+        // each chunk counts its buckets, then moves its elements in the order of the range: stable
+        const size_t chunks = chunksFor(m_pool, size);
+        std::vector<uint16_t> bucketOf(size);
+        std::vector<size_t> counts(chunks * buckets, 0);
+        forChunks(m_pool, size, chunks, [&](size_t chunk, size_t from, size_t to) {
+            size_t* count = &counts[chunk * buckets];
+            for (size_t i = from; i < to; ++i) {
+                const auto& value = m_first[begin + i];
+                const size_t s = std::lower_bound(splitters.begin(), splitters.end(), value, m_cmp) - splitters.begin();
+                const bool equal = s < splitters.size() && !m_cmp(value, splitters[s]);
+                bucketOf[i] = static_cast<uint16_t>(2 * s + equal);
+                ++count[bucketOf[i]];
+            }
+        });
+        std::vector<size_t> bucketStart(buckets + 1);
+        size_t position = begin;
+        for (size_t b = 0; b < buckets; ++b) {
+            bucketStart[b] = position;
+            for (size_t chunk = 0; chunk < chunks; ++chunk) {
+                const size_t count = counts[chunk * buckets + b];
+                counts[chunk * buckets + b] = position;    // where the chunk writes its next element of b
+                position += count;
+            }
+        }
+        bucketStart[buckets] = end;
+        forChunks(m_pool, size, chunks, [&](size_t chunk, size_t from, size_t to) {
+            size_t* next = &counts[chunk * buckets];
+            for (size_t i = from; i < to; ++i) m_buffer[next[bucketOf[i]]++] = std::move(m_first[begin + i]);
+        });
+        forChunks(m_pool, size, chunks, [&](size_t, size_t from, size_t to) {
+            std::move(m_buffer + begin + from, m_buffer + begin + to, m_first + begin + from);
+        });
+
+        for (size_t b = 0; b < buckets; b += 2) {
+            const size_t bucketBegin = bucketStart[b], bucketEnd = bucketStart[b + 1];
+            if (bucketEnd - bucketBegin > 1) {
+                m_pool.submit([this, bucketBegin, bucketEnd, &pending] { sort(bucketBegin, bucketEnd, pending); }, pending);
+            }
+        }
+    }
+
+ private:
+    // sorted, no 2 equal
+    std::vector<Value> sampleSplitters(size_t begin, size_t end) {
+        const size_t size = end - begin;
+        const size_t buckets = std::clamp(size / kSerialCutoff, size_t{2}, kMaxBuckets / 2);
+        std::mt19937_64 gen{size};
+        std::uniform_int_distribution<size_t> pick{begin, end - 1};
+        std::vector<Value> sample(buckets * kOversampling);
+        for (auto& value : sample) value = m_first[pick(gen)];
+        std::sort(sample.begin(), sample.end(), m_cmp);
+        std::vector<Value> splitters;
+        for (size_t i = kOversampling; i < sample.size(); i += kOversampling) {
+            if (splitters.empty() || m_cmp(splitters.back(), sample[i])) splitters.push_back(sample[i]);
+        }
+        return splitters;
+    }
+
+    WorkStealingPool& m_pool;
+    RandomIt m_first;
+    Compare m_cmp;
+    Value* m_buffer;
+};
+
+template<bool Stable, typename RandomIt, typename Compare>
+void sampleSort(RandomIt first, RandomIt last, Compare cmp, unsigned threads)
+{
+    const size_t size = last - first;
+    if (threads <= 1 || size <= kSerialCutoff) {
+        sortLeaf<Stable>(first, last, cmp);
+        return;
+    }
+    using Value = typename std::iterator_traits<RandomIt>::value_type;
+    std::vector<Value> buffer(size);
+    WorkStealingPool pool{threads};
+    SampleSort<Stable, RandomIt, Compare> sorter{pool, first, cmp, buffer.data()};
+    WorkStealingPool::Pending pending{0};
+    pool.submit([&] { sorter.sort(0, size, pending); }, pending);
+    pool.wait(pending);
+}
+
+} // namespace detail
+
+template<typename RandomIt, typename Compare = std::less<>>
+void sort(RandomIt first, RandomIt last, Compare cmp = Compare{}, unsigned threads = defaultThreads())
+{
+    detail::sampleSort<false>(first, last, cmp, threads);
+}
+
+template<typename RandomIt, typename Compare = std::less<>>
+void stableSort(RandomIt first, RandomIt last, Compare cmp = Compare{}, unsigned threads = defaultThreads())
+{
+    detail::sampleSort<true>(first, last, cmp, threads);
+}
+
+
+// 3. LSD radix sort on an integer key
+
+template<typename RandomIt, typename KeyOf>
+void radixSort(RandomIt first, RandomIt last, KeyOf keyOf, unsigned threads = defaultThreads())
+{
+    using Value = typename std::iterator_traits<RandomIt>::value_type;
+    using Key = std::decay_t<decltype(keyOf(*first))>;
+    static_assert(std::is_integral_v<Key>, "radixSort: integer keys only");
+    using Unsigned = std::make_unsigned_t<Key>;
+    constexpr size_t kPasses = sizeof(Key);
+    constexpr Unsigned kSignBit = std::is_signed_v<Key> ? Unsigned{1} << (8 * sizeof(Key) - 1) : 0;
+    // signed keys: flipping the sign bit orders the negative ones first
+    auto digits = [&keyOf](const Value& value) { return static_cast<Unsigned>(keyOf(value)) ^ kSignBit; };
+
+    const size_t size = last - first;
+    if (size <= 1) return;
+    WorkStealingPool pool{threads};
+    const size_t chunks = chunksFor(pool, size);
+
+    // counts[chunk][pass][digit] for all the passes at once
+    std::vector<size_t> counts(chunks * kPasses * 256, 0);
+    forChunks(pool, size, chunks, [&](size_t chunk, size_t from, size_t to) {
+        size_t* count = &counts[chunk * kPasses * 256];
+        for (size_t i = from; i < to; ++i) {
+            const Unsigned key = digits(first[i]);
+            for (size_t pass = 0; pass < kPasses; ++pass) ++count[pass * 256 + (key >> (8 * pass) & 0xFF)];
+        }
+    });
+
+    std::vector<Value> buffer(size);
+    Value* from = &*first;
+    Value* to = buffer.data();
+    bool moved = false;
+    for (size_t pass = 0; pass < kPasses; ++pass) {
+        // all in one bucket: this pass changes nothing
+        const size_t firstDigit = digits(from[0]) >> (8 * pass) & 0xFF;
+        size_t inFirst = 0;
+        for (size_t chunk = 0; chunk < chunks; ++chunk) inFirst += counts[(chunk * kPasses + pass) * 256 + firstDigit];
+        if (inFirst == size) continue;
+
+        // the chunks of the previous pass held other elements: count this digit again, chunk by chunk.
+        // One chunk holds all the elements whatever their order: its totals are still right
+        if (moved && chunks > 1) {
+            forChunks(pool, size, chunks, [&](size_t chunk, size_t begin, size_t end) {
+                size_t* count = &counts[(chunk * kPasses + pass) * 256];
+                std::fill(count, count + 256, 0);
+                for (size_t i = begin; i < end; ++i) ++count[digits(from[i]) >> (8 * pass) & 0xFF];
+            });
+        }
+        size_t position = 0;
+        for (size_t digit = 0; digit < 256; ++digit) {
+            for (size_t chunk = 0; chunk < chunks; ++chunk) {
+                size_t& count = counts[(chunk * kPasses + pass) * 256 + digit];
+                const size_t n = count;
+                count = position;
+                position += n;
+            }
+        }
+        forChunks(pool, size, chunks, [&](size_t chunk, size_t begin, size_t end) {
+            size_t* next = &counts[(chunk * kPasses + pass) * 256];
+            for (size_t i = begin; i < end; ++i) to[next[digits(from[i]) >> (8 * pass) & 0xFF]++] = std::move(from[i]);
+        });
+        std::swap(from, to);
+        moved = true;
+    }
+    if (from != &*first) std::move(from, from + size, first);
+}
+
+} // namespace parallel
+
+#endif // PARALLEL_SORT_H
@@ -0,0 +1,122 @@
+/*
+
+The operations of reorder.cpp and non_modif.cpp on millions of People (names of 5 to 14 letters, ages from 0 to 99),
+std::vector<People> against PeopleTable, ms:
+ - stable_partition: over 65 first
+ - median: nth_element then the age in the middle
+ - minmax: minmax_element by age
+ - stable_sort: by age
+ - names: reads all the names in the order of the rows (after the sort: lazy permutation of the table, then
+   after compact())
+
+1) g++ -std=c++17 -O2 -Wall -pedantic people_table.cpp -o people_table
+2) ./people_table 10000000    // from 10K up to 10M people (default 4M)
+
+*/
+
+#include "people_table.h"
+#include "../common/bench.h"
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <cassert>
+
+struct People {
+    std::string name;
+    int age;
+};
+
+bool operator<(const People& lhs, const People& rhs) {
+    return lhs.age < rhs.age;
+}
+
+template<typename T>
+size_t nameBytes(const T& people)
+{
+    size_t bytes = 0;
+    for (const auto& [name, age] : people) bytes += name.size() + name[0];
+    return bytes;
+}
+
+void benchmark(size_t size)
+{
+    std::mt19937 gen{42};
+    std::uniform_int_distribution<int> letter{'a', 'z'};
+    std::uniform_int_distribution<size_t> length{5, 14};
+    std::uniform_int_distribution<int> years{0, 99};
+    std::vector<People> record(size);
+    for (auto& [name, age] : record) {
+        name.resize(length(gen));
+        for (auto& c : name) c = static_cast<char>(letter(gen));
+        age = years(gen);
+    }
+    PeopleTable table{record.begin(), record.end()};
+    auto over65 = [](const auto& elem) { const auto& [name, age] = elem; return age > 65; };
+
+    std::vector<double> vectorMs, tableMs;
+    size_t selected = 0;
+    vectorMs.push_back(bench::msFor([&] { std::stable_partition(record.begin(), record.end(), over65); }));
+    tableMs.push_back(bench::msFor([&] { selected = table.stablePartition([](int age) { return age > 65; }); }));
+    assert(std::partition_point(record.begin(), record.end(), over65) - record.begin() == static_cast<std::ptrdiff_t>(selected));
+
+    int vectorMedian = 0, tableMedian = 0;
+    vectorMs.push_back(bench::msFor([&] {
+        const auto middle = record.size() / 2;
+        std::nth_element(record.begin(), record.begin() + middle, record.end());
+        vectorMedian = record[middle].age;
+    }));
+    tableMs.push_back(bench::msFor([&] { tableMedian = table.median(); }));
+    assert(vectorMedian == tableMedian);
+
+    int vectorMin = 0, vectorMax = 0;
+    std::pair<int, int> tableMinMax;
+    vectorMs.push_back(bench::msFor([&] {
+        const auto [min, max] = std::minmax_element(record.begin(), record.end());
+        vectorMin = min->age;
+        vectorMax = max->age;
+    }));
+    tableMs.push_back(bench::msFor([&] { tableMinMax = table.minmaxAge(); }));
+    assert(tableMinMax == std::make_pair(vectorMin, vectorMax));
+
+    // the median reordered the vector, not the table: both start sorting from the same order
+    table = PeopleTable{record.begin(), record.end()};
+    vectorMs.push_back(bench::msFor([&] { std::stable_sort(record.begin(), record.end()); }));
+    tableMs.push_back(bench::msFor([&] { table.stableSortByAge(); }));
+    for (size_t i = 0; i < size; i += size / 100 + 1) assert(table[i].name == record[i].name);
+
+    size_t bytes = 0;
+    vectorMs.push_back(bench::msFor([&] { bytes = nameBytes(record); }));
+    tableMs.push_back(bench::msFor([&] { bytes -= nameBytes(table); }));
+    const double compactMs = bench::msFor([&] { table.compact(); });
+    const double compactedMs = bench::msFor([&] { bytes += nameBytes(table); });
+    bench::keep(bytes + selected);
+
+    std::cout << std::setw(10) << size << "  vector";
+    for (double ms : vectorMs) std::cout << std::setw(17) << ms;
+    std::cout << "\n            table ";
+    for (double ms : tableMs) std::cout << std::setw(17) << ms;
+    std::cout << "   (compact " << compactMs << ", then names " << compactedMs << ")\n";
+}
+
+int main(int argc, char* argv[])
+{
+    // 1. record of reorder.cpp
+    const std::vector<People> record = {{"Cathy", 59},{"Rene", 99},{"Elon", 53},{"Leon", 13},{"Arthur", 99},{"Anna", 43}};
+    PeopleTable table{record.begin(), record.end()};
+    table.stablePartition([](int age) { return age > 65; });
+    std::cout << "median is " << table.median() << "\n";
+    table.stableSortByAge();
+    for (const auto& [name, age] : table) std::cout << "[ " << name << ":" << age << " ]";
+    std::cout << "\n\n";
+
+    // 2. benchmark
+    const size_t maxSize = argc > 1 ? std::stoul(argv[1]) : 4'000'000;
+    std::cout << "    people  storage  stable_partition           median           minmax      stable_sort            names  (ms)\n";
+    for (size_t size = 10'000; size <= maxSize; size *= 20) {
+        benchmark(size);
+    }
+}
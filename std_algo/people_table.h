@@ -0,0 +1,185 @@
+/*
+
+PeopleTable: the People of reorder.cpp and non_modif.cpp stored by column instead of a std::vector<People>.
+
+In a std::vector<People> every element is 40 bytes (a 32 bytes std::string and the age): partitioning, sorting or
+looking for the median by age moves and drags the whole strings through the cache. The table keeps:
+ - the ages in one contiguous column, 4 bytes per person
+ - the names back to back in one pool, with their offsets
+ - a row id column: row i of the table has the name m_names[m_ids[i]]
+
+The operations only work on the age and row id columns, the names never move: the permutation is applied lazily,
+when a name is read. After many reorders, compact() rewrites the pool in the order of the rows so that reading the
+names is sequential again.
+
+    PeopleTable table{record.begin(), record.end()};
+    table.stablePartition([](int age) { return age > 65; });
+    const int median = table.median();
+    table.stableSortByAge();
+    for (const auto& [name, age] : table) std::cout << name << ":" << age;
+
+C++17
+
+*/
+
+#ifndef PEOPLE_TABLE_H
+#define PEOPLE_TABLE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+class PeopleTable {
+ public:
+    struct Row {
+        std::string_view name;
+        int age;
+    };
+
+    class Iterator {
+     public:
+        using value_type = Row;
+        using reference = Row;
+        using pointer = void;
+        using difference_type = std::ptrdiff_t;
+        using iterator_category = std::input_iterator_tag;
+
+        Iterator(const PeopleTable* table, size_t row):m_table{table},m_row{row} {}
+        Row operator*() const { return (*m_table)[m_row]; }
+        Iterator& operator++() { ++m_row; return *this; }
+        Iterator operator++(int) { auto previous = *this; ++m_row; return previous; }
+        bool operator==(const Iterator& other) const { return m_row == other.m_row; }
+        bool operator!=(const Iterator& other) const { return m_row != other.m_row; }
+
+     private:
+        const PeopleTable* m_table;
+        size_t m_row;
+    };
+
+    PeopleTable() = default;
+
+    // from any range of People like elements: const auto& [name, age] = *it
+    template<typename InputIt>
+    PeopleTable(InputIt first, InputIt last) {
+        for (; first != last; ++first) {
+            const auto& [name, age] = *first;
+            push_back(name, age);
+        }
+    }
+
+    void push_back(std::string_view name, int age) {
+        if (m_pool.size() + name.size() > UINT32_MAX) throw std::length_error{"PeopleTable: more than 4GB of names"};
+        m_ids.push_back(static_cast<uint32_t>(m_offsets.size() - 1));
+        m_ages.push_back(age);
+        m_pool.append(name);
+        m_offsets.push_back(static_cast<uint32_t>(m_pool.size()));
+    }
+
+    void reserve(size_t rows, size_t nameBytes) {
+        m_ages.reserve(rows);
+        m_ids.reserve(rows);
+        m_offsets.reserve(rows + 1);
+        m_pool.reserve(nameBytes);
+    }
+
+    Row operator[](size_t row) const { return {name(row), m_ages[row]}; }
+    std::string_view name(size_t row) const {
+        const uint32_t id = m_ids[row];
+        return std::string_view{m_pool}.substr(m_offsets[id], m_offsets[id + 1] - m_offsets[id]);
+    }
+    int age(size_t row) const { return m_ages[row]; }
+    const std::vector<int>& ages() const { return m_ages; }
+    size_t size() const { return m_ages.size(); }
+    bool empty() const { return m_ages.empty(); }
+
+    Iterator begin() const { return {this, 0}; }
+    Iterator end() const { return {this, size()}; }
+    Iterator cbegin() const { return begin(); }
+    Iterator cend() const { return end(); }
+
+    // std::stable_partition on the ages: the rows where pred(age) is true first, returns how many
+    template<typename Pred>
+    size_t stablePartition(Pred pred) {
+        const size_t size = m_ages.size();
+        size_t selected = 0;
+        for (int age : m_ages) selected += pred(age) ? 1 : 0;
+        std::vector<int> ages(size);
+        std::vector<uint32_t> ids(size);
+        size_t front = 0, back = selected;
+        for (size_t row = 0; row < size; ++row) {
+            const bool first = pred(m_ages[row]);
+            size_t& to = first ? front : back;
+            ages[to] = m_ages[row];
+            ids[to++] = m_ids[row];
+        }
+        m_ages.swap(ages);
+        m_ids.swap(ids);
+        return selected;
+    }
+
+    // the age nth would have after a sort, the rows keep their order (nth_element on a copy of the ages)
+    int nthAge(size_t nth) const {
+        if (nth >= m_ages.size()) throw std::out_of_range{"PeopleTable::nthAge"};
+        std::vector<int> ages{m_ages};
+        std::nth_element(ages.begin(), ages.begin() + nth, ages.end());
+        return ages[nth];
+    }
+    int median() const { return nthAge(m_ages.size() / 2); }
+
+    std::pair<int, int> minmaxAge() const {
+        if (m_ages.empty()) throw std::out_of_range{"PeopleTable::minmaxAge: empty table"};
+        const auto [min, max] = std::minmax_element(m_ages.begin(), m_ages.end());
+        return {*min, *max};
+    }
+
+    // std::stable_sort by age: counting sort when the ages span less than 64K values (2 passes of 16 bits otherwise)
+    void stableSortByAge() {
+        if (m_ages.size() <= 1) return;
+        const auto [min, max] = minmaxAge();
+        const uint32_t span = static_cast<uint32_t>(static_cast<int64_t>(max) - min);
+        std::vector<int> ages(m_ages.size());
+        std::vector<uint32_t> ids(m_ids.size());
+        for (int shift = 0; shift < 32 && (span >> shift) != 0; shift += 16) {
+            auto digit = [min, shift](int age) { return (static_cast<uint32_t>(static_cast<int64_t>(age) - min) >> shift) & 0xFFFF; };
+            std::vector<size_t> next(1 << 16, 0);
+            for (int age : m_ages) ++next[digit(age)];
+            size_t position = 0;
+            for (auto& count : next) position += std::exchange(count, position);
+            for (size_t row = 0; row < m_ages.size(); ++row) {
+                const size_t to = next[digit(m_ages[row])]++;
+                ages[to] = m_ages[row];
+                ids[to] = m_ids[row];
+            }
+            m_ages.swap(ages);
+            m_ids.swap(ids);
+        }
+    }
+
+    // the names stored again in the order of the rows
+    void compact() {
+        std::string pool;
+        pool.reserve(m_pool.size());
+        std::vector<uint32_t> offsets{0};
+        offsets.reserve(m_offsets.size());
+        for (size_t row = 0; row < size(); ++row) {
+            pool.append(name(row));
+            offsets.push_back(static_cast<uint32_t>(pool.size()));
+            m_ids[row] = static_cast<uint32_t>(row);
+        }
+        m_pool.swap(pool);
+        m_offsets.swap(offsets);
+    }
+
+ private:
+    std::vector<int> m_ages;
+    std::vector<uint32_t> m_ids;            // row -> name
+    std::vector<uint32_t> m_offsets{0};     // name i is m_pool[m_offsets[i], m_offsets[i + 1])
+    std::string m_pool;
+};
+
+#endif // PEOPLE_TABLE_H
@@ -0,0 +1,187 @@
+/*
+
+The multi-pass code of vector.cpp and non_modif.cpp (copy_if into a back_inserter, erase_if, transform, then the
+algorithm) against the same work as one pipeline (pipeline.h), on millions of random int, time in ms and MB allocated
+by the intermediate vectors (counted by their allocator, the pipelines have none):
+ - even squares: copy_if then transform, into a vector / pipeline into a preallocated buffer
+ - minmax: copy_if, transform then minmax_element / pipeline | minmax(), serial and on the pool
+ - all_of: same for all_of
+ - 10 old people: copy of the record, erase_if the young ones, first 10 names / filter | take(10) | transform
+
+1) g++ -std=c++17 -O2 -Wall -pedantic pipeline.cpp -o pipeline -pthread
+2) ./pipeline 50000000 8    // 50M int, pool of 8 threads (default 20M, all the cores)
+
+*/
+
+#include "pipeline.h"
+#include "../common/bench.h"
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <experimental/vector>
+#include <functional>
+#include <random>
+#include <chrono>
+#include <cassert>
+
+// bytes allocated by the intermediate vectors of the multi-pass code
+size_t g_allocated = 0;
+
+template<typename T>
+struct CountingAllocator {
+    using value_type = T;
+    CountingAllocator() = default;
+    template<typename U>
+    CountingAllocator(const CountingAllocator<U>&) {}
+    T* allocate(size_t n) {
+        g_allocated += n * sizeof(T);
+        return std::allocator<T>{}.allocate(n);
+    }
+    void deallocate(T* p, size_t n) { std::allocator<T>{}.deallocate(p, n); }
+    friend bool operator==(const CountingAllocator&, const CountingAllocator&) { return true; }
+    friend bool operator!=(const CountingAllocator&, const CountingAllocator&) { return false; }
+};
+
+template<typename T>
+using CountedVector = std::vector<T, CountingAllocator<T>>;
+
+struct People {
+    std::string name;
+    int age;
+};
+
+struct Measure {
+    double ms;
+    double mb;
+};
+
+template<typename F>
+Measure measure(F&& f)
+{
+    const size_t allocated = g_allocated;
+    auto start = std::chrono::steady_clock::now();
+    f();
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return {elapsed.count(), (g_allocated - allocated) / 1e6};
+}
+
+void printRow(const char* name, Measure multiPass, Measure fused, std::optional<Measure> pool = std::nullopt)
+{
+    std::cout << std::setw(14) << name << std::fixed << std::setprecision(1)
+              << std::setw(11) << multiPass.ms << std::setw(8) << multiPass.mb
+              << std::setw(11) << fused.ms << std::setw(8) << fused.mb;
+    if (pool) std::cout << std::setw(11) << pool->ms;
+    std::cout << "\n";
+}
+
+int main(int argc, char* argv[])
+{
+    auto even = [](int elem) { return elem % 2 == 0; };
+    auto square = [](int elem) { return static_cast<long long>(elem) * elem; };
+
+    // 1. v1 of vector.cpp
+    const std::vector<int> v1 = {11, 12, 21, 5, 40, 50, 3, 1, 1, 1, 1, 60};
+    std::vector<long long> v4(v1.size());
+    const auto last = pipeline::from(v1) | pipeline::filter(even) | pipeline::transform(square) | pipeline::into(v4.begin());
+    v4.erase(last, v4.end());
+    for (auto elem : v4) std::cout << elem << ",";
+    std::cout << "\n";
+    pipeline::from(v1) | pipeline::enumerate() | pipeline::chunk(5) | pipeline::forEach([](const auto& chunk) {
+        for (const auto& [index, elem] : chunk) std::cout << index << ":" << elem << " ";
+        std::cout << "| ";
+    });
+    std::cout << "\n";
+    // the terminals keep copies: v1 is not modified and the chunks outlive their reused buffer
+    auto bySecond = [](const auto& lhs, const auto& rhs) { return lhs.second < rhs.second; };
+    const auto [min, max] = *(pipeline::from(v1) | pipeline::enumerate() | pipeline::minmax(bySecond));
+    assert(min.first == 7 && min.second == 1 && max.first == 11 && max.second == 60 && v1[0] == 11);
+    std::cout << "min " << min.second << " at " << min.first << ", max " << max.second << " at " << max.first << "\n";
+    const auto chunks = pipeline::from(v1) | pipeline::chunk(5) | pipeline::enumerate() | pipeline::toVector();
+    assert(chunks.size() == 3 && chunks[1].second[0] == 50 && chunks[2].second.size() == 2);
+    for (const auto& [index, chunk] : chunks) std::cout << index << ":" << chunk.front() << ".." << chunk.back() << " ";
+    std::cout << "\n\n";
+
+    // 2. benchmark
+    const size_t size = argc > 1 ? std::stoul(argv[1]) : 20'000'000;
+    const unsigned threads = argc > 2 ? std::stoul(argv[2]) : parallel::defaultThreads();
+    parallel::WorkStealingPool pool{threads};
+    std::mt19937 gen{42};
+    std::uniform_int_distribution<int> values{0, 1'000'000};
+    std::vector<int> v(size);
+    for (auto& elem : v) elem = values(gen);
+    const auto evenSquares = pipeline::from(v) | pipeline::filter(even) | pipeline::transform(square);
+
+    std::cout << size << " int, pool of " << threads << " threads\n";
+    std::cout << "                  multi-pass          pipeline      on pool\n";
+    std::cout << "                  ms      MB         ms      MB         ms\n";
+
+    CountedVector<long long> squares;
+    const auto multiSquares = measure([&] {
+        CountedVector<int> evens;
+        std::copy_if(v.begin(), v.end(), std::back_inserter(evens), even);
+        std::transform(evens.begin(), evens.end(), std::back_inserter(squares), square);
+    });
+    std::vector<long long> buffer(size);
+    std::vector<long long>::iterator bufferEnd;
+    const auto fusedSquares = measure([&] { bufferEnd = evenSquares | pipeline::into(buffer.begin()); });
+    assert(std::equal(squares.begin(), squares.end(), buffer.begin(), bufferEnd));
+    printRow("even squares", multiSquares, fusedSquares);
+
+    std::pair<long long, long long> multiMinMax;
+    const auto multiMinMaxMs = measure([&] {
+        CountedVector<int> evens;
+        std::copy_if(v.begin(), v.end(), std::back_inserter(evens), even);
+        CountedVector<long long> squares;
+        std::transform(evens.begin(), evens.end(), std::back_inserter(squares), square);
+        const auto [min, max] = std::minmax_element(squares.begin(), squares.end());
+        multiMinMax = {*min, *max};
+    });
+    std::optional<std::pair<long long, long long>> fusedMinMax, poolMinMax;
+    const auto fusedMinMaxMs = measure([&] { fusedMinMax = evenSquares | pipeline::minmax(); });
+    const auto poolMinMaxMs = measure([&] { poolMinMax = evenSquares | pipeline::on(pool) | pipeline::minmax(); });
+    assert(fusedMinMax == multiMinMax && poolMinMax == multiMinMax);
+    printRow("minmax", multiMinMaxMs, fusedMinMaxMs, poolMinMaxMs);
+
+    auto inRange = [](long long elem) { return elem >= 0 && elem <= 1'000'000LL * 1'000'000; };
+    bool multiAll = false, fusedAll = false, poolAll = false;
+    const auto multiAllMs = measure([&] {
+        CountedVector<int> evens;
+        std::copy_if(v.begin(), v.end(), std::back_inserter(evens), even);
+        CountedVector<long long> squares;
+        std::transform(evens.begin(), evens.end(), std::back_inserter(squares), square);
+        multiAll = std::all_of(squares.begin(), squares.end(), inRange);
+    });
+    const auto fusedAllMs = measure([&] { fusedAll = evenSquares | pipeline::allOf(inRange); });
+    const auto poolAllMs = measure([&] { poolAll = evenSquares | pipeline::on(pool) | pipeline::allOf(inRange); });
+    assert(multiAll && fusedAll && poolAll);
+    printRow("all_of", multiAllMs, fusedAllMs, poolAllMs);
+
+    // record of a few millions people, names of 8 letters
+    std::uniform_int_distribution<int> letter{'a', 'z'};
+    std::uniform_int_distribution<int> years{0, 99};
+    std::vector<People> record(size / 10);
+    for (auto& [name, age] : record) {
+        name.resize(8);
+        for (auto& c : name) c = static_cast<char>(letter(gen));
+        age = years(gen);
+    }
+    auto over65 = [](const People& people) { return people.age > 65; };
+    std::vector<std::string> multiNames, fusedNames;
+    const auto multiOld = measure([&] {
+        CountedVector<People> v5(record.begin(), record.end());
+        std::experimental::erase_if(v5, std::not_fn(over65));
+        for (size_t i = 0; i < std::min<size_t>(10, v5.size()); ++i) multiNames.push_back(v5[i].name);
+    });
+    const auto fusedOld = measure([&] {
+        fusedNames = pipeline::from(record) | pipeline::filter(over65) | pipeline::take(10)
+                   | pipeline::transform([](const People& people) { return people.name; }) | pipeline::toVector(10);
+    });
+    assert(multiNames == fusedNames);
+    printRow("10 old people", multiOld, fusedOld);
+
+    bench::keep(squares.size() + multiMinMax.first);
+}
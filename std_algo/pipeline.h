@@ -0,0 +1,550 @@
+/*
+
+Lazy pipelines over a range: the stages are composed with | and run in one single loop, no intermediate vector.
+
+    auto even = [](int elem) { return elem % 2 == 0; };
+    std::vector<int> v4(v1.size());
+    auto last = pipeline::from(v1) | pipeline::filter(even) | pipeline::transform(square) | pipeline::into(v4.begin());
+    auto [min, max] = *(pipeline::from(v1) | pipeline::filter(even) | pipeline::minmax());
+    bool old = pipeline::from(record) | pipeline::on(pool) | pipeline::anyOf([](const People& p) { return p.age > 65; });
+
+Stages (lazy, nothing runs before a terminal):
+ - filter(pred), transform(f)
+ - take(n): stops the loop over the source after n elements
+ - chunk(n): groups of n elements as a const std::vector& (the last one can be shorter), the vector is reused
+ - enumerate(): std::pair{index, element}, the element by reference: the terminals store std::pair{index, copy}
+
+Terminals: run the loop and return the result:
+ - forEach(f), into(out) (preallocated buffer or back_inserter, returns out), toVector(), count()
+ - reduce(init, op), minmax(cmp) (std::optional of {min, max}, same elements as std::minmax_element)
+ - allOf(pred), anyOf(pred), noneOf(pred): stop at the first element that decides
+
+Every stage wraps the sink that follows it (push model): the source calls the first sink for each element, a sink
+returns false to stop the loop. After on(pool), count / reduce / minmax / allOf / anyOf / noneOf split the source
+into chunks run on the parallel::WorkStealingPool of parallel_sort.h and combine the results of the chunks in their
+order; anyOf, allOf and noneOf stop the other chunks once one decided. Only with a random access source and
+filter / transform stages: take, chunk and enumerate depend on the elements before them, these pipelines run serially.
+reduce on a pool needs an associative op, like std::reduce.
+
+C++17
+
+*/
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include "parallel_sort.h"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <iterator>
+#include <optional>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace pipeline {
+
+constexpr size_t kParallelCutoff = 1 << 16;     // below: the reductions run serially
+constexpr size_t kCancelBlock = 1 << 12;        // elements between 2 checks of the stop flag
+
+
+// 1. Stages: Out<In> is the type passed to the next sink, Sink<In, Next> the wrapper created for each run
+
+template<typename Pred>
+struct Filter {
+    static constexpr bool kSplittable = true;
+    template<typename In> using Out = In;
+
+    template<typename In, typename Next>
+    struct Sink {
+        const Pred& pred;
+        Next next;
+        bool operator()(In value) { return !pred(std::as_const(value)) || next(std::forward<In>(value)); }
+        void finish() { next.finish(); }
+    };
+
+    template<typename In, typename Next>
+    Sink<In, Next> wrap(Next next) const { return {pred, std::forward<Next>(next)}; }
+
+    Pred pred;
+};
+
+template<typename F>
+struct Transform {
+    static constexpr bool kSplittable = true;
+    template<typename In> using Out = std::invoke_result_t<const F&, In>;
+
+    template<typename In, typename Next>
+    struct Sink {
+        const F& f;
+        Next next;
+        bool operator()(In value) { return next(std::invoke(f, std::forward<In>(value))); }
+        void finish() { next.finish(); }
+    };
+
+    template<typename In, typename Next>
+    Sink<In, Next> wrap(Next next) const { return {f, std::forward<Next>(next)}; }
+
+    F f;
+};
+
+struct Take {
+    static constexpr bool kSplittable = false;
+    template<typename In> using Out = In;
+
+    template<typename In, typename Next>
+    struct Sink {
+        size_t left;
+        Next next;
+        bool operator()(In value) {
+            if (left == 0) return false;
+            --left;
+            return next(std::forward<In>(value)) && left > 0;
+        }
+        void finish() { next.finish(); }
+    };
+
+    template<typename In, typename Next>
+    Sink<In, Next> wrap(Next next) const { return {count, std::forward<Next>(next)}; }
+
+    size_t count;
+};
+
+struct Chunk {
+    static constexpr bool kSplittable = false;
+    template<typename In> using Out = const std::vector<std::decay_t<In>>&;
+
+    template<typename In, typename Next>
+    struct Sink {
+        std::vector<std::decay_t<In>> chunk;
+        size_t size;
+        Next next;
+        bool stopped = false;
+        bool operator()(In value) {
+            chunk.push_back(std::forward<In>(value));
+            if (chunk.size() < size) return true;
+            stopped = !next(std::as_const(chunk));
+            chunk.clear();
+            return !stopped;
+        }
+        void finish() {
+            if (!stopped && !chunk.empty()) next(std::as_const(chunk));
+            next.finish();
+        }
+    };
+
+    template<typename In, typename Next>
+    Sink<In, Next> wrap(Next next) const {
+        Sink<In, Next> sink{{}, size, std::forward<Next>(next)};
+        sink.chunk.reserve(size);
+        return sink;
+    }
+
+    size_t size;
+};
+
+struct Enumerate {
+    static constexpr bool kSplittable = false;
+    template<typename In> using Out = std::pair<size_t, In>;
+
+    template<typename In, typename Next>
+    struct Sink {
+        size_t index;
+        Next next;
+        bool operator()(In value) { return next(Out<In>{index++, std::forward<In>(value)}); }
+        void finish() { next.finish(); }
+    };
+
+    template<typename In, typename Next>
+    Sink<In, Next> wrap(Next next) const { return {0, std::forward<Next>(next)}; }
+};
+
+template<typename Pred>
+Filter<Pred> filter(Pred pred) { return {std::move(pred)}; }
+
+template<typename F>
+Transform<F> transform(F f) { return {std::move(f)}; }
+
+inline Take take(size_t count) { return {count}; }
+
+inline Chunk chunk(size_t size)
+{
+    if (size == 0) throw std::invalid_argument{"pipeline::chunk: size 0"};
+    return {size};
+}
+
+inline Enumerate enumerate() { return {}; }
+
+struct On {
+    parallel::WorkStealingPool* pool;
+};
+
+inline On on(parallel::WorkStealingPool& pool) { return {&pool}; }
+
+
+// 2. Pipeline: the source and the stages
+
+namespace detail {
+
+template<typename In, typename... Stages>
+struct Output {
+    using type = In;
+};
+
+template<typename In, typename Stage, typename... Rest>
+struct Output<In, Stage, Rest...> {
+    using type = typename Output<typename Stage::template Out<In>, Rest...>::type;
+};
+
+// the type stored by the terminals: enumerate() passes std::pair<size_t, T&>, stored as std::pair<size_t, T>
+template<typename T>
+struct Value {
+    using type = std::decay_t<T>;
+};
+
+template<typename First, typename Second>
+struct Value<std::pair<First, Second>> {
+    using type = std::pair<typename Value<First>::type, typename Value<Second>::type>;
+};
+
+// the end of the chain: the sink of the terminal, by reference
+template<typename Sink>
+struct Ref {
+    Sink& sink;
+    template<typename T>
+    bool operator()(T&& value) { return sink(std::forward<T>(value)); }
+    void finish() { sink.finish(); }
+};
+
+} // namespace detail
+
+template<typename It, typename... Stages>
+class Pipeline {
+ public:
+    using source_reference = typename std::iterator_traits<It>::reference;
+    using reference = typename detail::Output<source_reference, Stages...>::type;
+    using value_type = typename detail::Value<std::decay_t<reference>>::type;
+
+    static constexpr bool kSplittable = (std::is_base_of_v<std::random_access_iterator_tag,
+                                            typename std::iterator_traits<It>::iterator_category> && ... && Stages::kSplittable);
+
+    Pipeline(It first, It last, std::tuple<Stages...> stages = {}, parallel::WorkStealingPool* pool = nullptr)
+        :m_first{first},m_last{last},m_stages{std::move(stages)},m_pool{pool} {}
+
+    template<typename Stage>
+    Pipeline<It, Stages..., Stage> then(Stage stage) const {
+        return {m_first, m_last, std::tuple_cat(m_stages, std::make_tuple(std::move(stage))), m_pool};
+    }
+
+    Pipeline on(parallel::WorkStealingPool* pool) const { return {m_first, m_last, m_stages, pool}; }
+
+    // the whole source into sink (a callable returning false to stop, with finish()): returns false if it stopped
+    template<typename Sink>
+    bool push(Sink& sink) const { return push(m_first, m_last, sink, nullptr); }
+
+    // one sink per chunk of the source, on the pool when the pipeline can be split: make(chunk) creates the sinks,
+    // with cancel the other chunks stop as soon as one sink stopped. The sinks are returned in the source order
+    template<typename MakeSink>
+    auto split(MakeSink make, bool cancel) const {
+        std::vector<decltype(make(size_t{0}))> sinks;
+        if constexpr (kSplittable) {
+            const size_t size = static_cast<size_t>(m_last - m_first);
+            if (m_pool != nullptr && m_pool->threads() > 1 && size >= kParallelCutoff) {
+                const size_t chunks = std::min(m_pool->threads() * 4, size / (kParallelCutoff / 4));
+                for (size_t chunk = 0; chunk < chunks; ++chunk) sinks.push_back(make(chunk));
+                std::atomic<bool> stop{false};
+                parallel::forChunks(*m_pool, size, chunks, [&](size_t chunk, size_t first, size_t last) {
+                    if (!push(m_first + first, m_first + last, sinks[chunk], cancel ? &stop : nullptr)) {
+                        stop.store(true, std::memory_order_relaxed);
+                    }
+                });
+                return sinks;
+            }
+        }
+        sinks.push_back(make(0));
+        push(sinks.front());
+        return sinks;
+    }
+
+ private:
+    template<size_t I, typename In, typename Sink>
+    auto wrap(Sink& sink) const {
+        if constexpr (I == sizeof...(Stages)) {
+            return detail::Ref<Sink>{sink};
+        }
+        else {
+            const auto& stage = std::get<I>(m_stages);
+            using Out = typename std::tuple_element_t<I, std::tuple<Stages...>>::template Out<In>;
+            return stage.template wrap<In>(wrap<I + 1, Out>(sink));
+        }
+    }
+
+    template<typename Sink>
+    bool push(It first, It last, Sink& sink, const std::atomic<bool>* stop) const {
+        auto chain = wrap<0, source_reference>(sink);
+        bool more = true;
+        if constexpr (kSplittable) {
+            // checks the stop flag every kCancelBlock elements
+            while (more && first != last && !(stop && stop->load(std::memory_order_relaxed))) {
+                const It blockEnd = stop ? first + std::min<std::ptrdiff_t>(kCancelBlock, last - first) : last;
+                for (; first != blockEnd && more; ++first) more = chain(*first);
+            }
+        }
+        else {
+            for (; first != last && more; ++first) more = chain(*first);
+        }
+        chain.finish();
+        return more;
+    }
+
+    It m_first;
+    It m_last;
+    std::tuple<Stages...> m_stages;
+    parallel::WorkStealingPool* m_pool;
+};
+
+template<typename Range>
+auto from(Range& range)
+{
+    return Pipeline<decltype(std::begin(range))>{std::begin(range), std::end(range)};
+}
+
+template<typename It>
+Pipeline<It> from(It first, It last)
+{
+    return {first, last};
+}
+
+
+// 3. Terminals: pipeline | terminal pushes the source through the stages into the sink of the terminal
+
+namespace detail {
+
+struct CountSink {
+    size_t count = 0;
+    template<typename T>
+    bool operator()(T&&) { ++count; return true; }
+    void finish() {}
+};
+
+template<typename T, typename Op>
+struct ReduceSink {
+    std::optional<T> acc;
+    const Op* op;
+    template<typename V>
+    bool operator()(V&& value) {
+        if (acc) *acc = (*op)(std::move(*acc), std::forward<V>(value));
+        else acc.emplace(std::forward<V>(value));
+        return true;
+    }
+    void finish() {}
+};
+
+template<typename V, typename Compare>
+struct MinMaxSink {
+    std::optional<std::pair<V, V>> result;
+    const Compare* cmp;
+    template<typename T>
+    bool operator()(const T& value) {
+        if (!result) {
+            result.emplace(value, value);
+            return true;
+        }
+        if ((*cmp)(value, result->first)) result->first = value;           // the first smallest
+        if (!(*cmp)(value, result->second)) result->second = value;        // the last largest
+        return true;
+    }
+    void finish() {}
+};
+
+template<typename Pred>
+struct AnySink {
+    const Pred* pred;
+    bool found = false;
+    template<typename T>
+    bool operator()(const T& value) {
+        found = (*pred)(value);
+        return !found;
+    }
+    void finish() {}
+};
+
+template<typename F>
+struct ForEachSink {
+    F* f;
+    template<typename T>
+    bool operator()(T&& value) { (*f)(std::forward<T>(value)); return true; }
+    void finish() {}
+};
+
+template<typename OutIt>
+struct IntoSink {
+    OutIt out;
+    template<typename T>
+    bool operator()(T&& value) { *out = std::forward<T>(value); ++out; return true; }
+    void finish() {}
+};
+
+template<typename T, typename = void>
+struct IsStage : std::false_type {};
+template<typename T>
+struct IsStage<T, std::void_t<decltype(T::kSplittable)>> : std::true_type {};
+
+template<typename T, typename = void>
+struct IsTerminal : std::false_type {};
+template<typename T>
+struct IsTerminal<T, std::void_t<decltype(T::kTerminal)>> : std::true_type {};
+
+} // namespace detail
+
+template<typename F>
+struct ForEach {
+    static constexpr bool kTerminal = true;
+    F f;
+    template<typename Pipe>
+    void run(const Pipe& pipe) {
+        detail::ForEachSink<F> sink{&f};
+        pipe.push(sink);
+    }
+};
+
+template<typename OutIt>
+struct Into {
+    static constexpr bool kTerminal = true;
+    OutIt out;
+    template<typename Pipe>
+    OutIt run(const Pipe& pipe) {
+        detail::IntoSink<OutIt> sink{out};
+        pipe.push(sink);
+        return sink.out;
+    }
+};
+
+struct ToVector {
+    static constexpr bool kTerminal = true;
+    size_t capacity;
+    template<typename Pipe>
+    auto run(const Pipe& pipe) {
+        std::vector<typename Pipe::value_type> result;
+        result.reserve(capacity);
+        detail::IntoSink<std::back_insert_iterator<decltype(result)>> sink{std::back_inserter(result)};
+        pipe.push(sink);
+        return result;
+    }
+};
+
+struct Count {
+    static constexpr bool kTerminal = true;
+    template<typename Pipe>
+    size_t run(const Pipe& pipe) {
+        size_t count = 0;
+        for (const auto& sink : pipe.split([](size_t) { return detail::CountSink{}; }, false)) count += sink.count;
+        return count;
+    }
+};
+
+template<typename T, typename Op>
+struct Reduce {
+    static constexpr bool kTerminal = true;
+    T init;
+    Op op;
+    template<typename Pipe>
+    T run(const Pipe& pipe) {
+        auto sinks = pipe.split([this](size_t chunk) {
+            return detail::ReduceSink<T, Op>{chunk == 0 ? std::optional<T>{init} : std::nullopt, &op};
+        }, false);
+        T result = std::move(*sinks.front().acc);
+        for (size_t chunk = 1; chunk < sinks.size(); ++chunk) {
+            if (sinks[chunk].acc) result = op(std::move(result), std::move(*sinks[chunk].acc));
+        }
+        return result;
+    }
+};
+
+template<typename Compare>
+struct MinMax {
+    static constexpr bool kTerminal = true;
+    Compare cmp;
+    template<typename Pipe>
+    auto run(const Pipe& pipe) {
+        using Sink = detail::MinMaxSink<typename Pipe::value_type, Compare>;
+        std::optional<std::pair<typename Pipe::value_type, typename Pipe::value_type>> result;
+        for (auto& sink : pipe.split([this](size_t) { return Sink{std::nullopt, &cmp}; }, false)) {
+            if (!sink.result) continue;
+            if (!result) result = std::move(sink.result);
+            else {
+                if (cmp(sink.result->first, result->first)) result->first = std::move(sink.result->first);
+                if (!cmp(sink.result->second, result->second)) result->second = std::move(sink.result->second);
+            }
+        }
+        return result;
+    }
+};
+
+// anyOf, allOf (anyOf not pred) and noneOf
+template<typename Pred>
+struct AnyOf {
+    static constexpr bool kTerminal = true;
+    Pred pred;
+    bool negate;
+    template<typename Pipe>
+    bool run(const Pipe& pipe) {
+        const auto sinks = pipe.split([this](size_t) { return detail::AnySink<Pred>{&pred}; }, true);
+        const bool found = std::any_of(sinks.begin(), sinks.end(), [](const auto& sink) { return sink.found; });
+        return found != negate;
+    }
+};
+
+template<typename F>
+ForEach<F> forEach(F f) { return {std::move(f)}; }
+
+template<typename OutIt>
+Into<OutIt> into(OutIt out) { return {std::move(out)}; }
+
+inline ToVector toVector(size_t capacity = 0) { return {capacity}; }
+
+inline Count count() { return {}; }
+
+template<typename T, typename Op = std::plus<>>
+Reduce<T, Op> reduce(T init, Op op = Op{}) { return {std::move(init), std::move(op)}; }
+
+template<typename Compare = std::less<>>
+MinMax<Compare> minmax(Compare cmp = Compare{}) { return {std::move(cmp)}; }
+
+template<typename Pred>
+AnyOf<Pred> anyOf(Pred pred) { return {std::move(pred), false}; }
+
+template<typename Pred>
+auto allOf(Pred pred) { return AnyOf<decltype(std::not_fn(pred))>{std::not_fn(std::move(pred)), true}; }
+
+template<typename Pred>
+auto noneOf(Pred pred) { return AnyOf<Pred>{std::move(pred), true}; }
+
+
+// 4. Composition with |
+
+template<typename It, typename... Stages, typename Stage, std::enable_if_t<detail::IsStage<Stage>::value, int> = 0>
+Pipeline<It, Stages..., Stage> operator|(const Pipeline<It, Stages...>& pipe, Stage stage)
+{
+    return pipe.then(std::move(stage));
+}
+
+template<typename It, typename... Stages>
+Pipeline<It, Stages...> operator|(const Pipeline<It, Stages...>& pipe, On on)
+{
+    return pipe.on(on.pool);
+}
+
+template<typename It, typename... Stages, typename Terminal, std::enable_if_t<detail::IsTerminal<Terminal>::value, int> = 0>
+auto operator|(const Pipeline<It, Stages...>& pipe, Terminal terminal)
+{
+    return terminal.run(pipe);
+}
+
+} // namespace pipeline
+
+#endif // PIPELINE_H
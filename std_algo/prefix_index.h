@@ -0,0 +1,331 @@
+/*
+
+PrefixIndex: autocomplete over millions of words, the words that start with a prefix as std::string_view and the
+k best of them by score.
+
+The words are sorted and stored back to back in one pool, with their offsets and their scores:
+ - a table of 64K entries gives the range of the words for each 2 first bytes, a prefix of 2 bytes or more is then
+   searched with 16 steps less (string_view comparisons, no allocation)
+ - topK: the scores are split in blocks of 64 with a sparse table of the best word of every 2^l consecutive blocks.
+   The best of any range is then 2 lookups and 2 partial block scans, the k best are taken from a heap of ranges
+   (the best of a range, then the best of the 2 ranges left on each side of it)
+
+The whole index is one flat buffer of 8 bytes aligned sections: Builder::save() writes it as is and open() maps
+the file (mmap): nothing is parsed or copied at startup, the pages are loaded on the first queries.
+The file uses the byte order of the machine that wrote it. Words must not contain '\0'.
+
+    PrefixIndex::Builder builder;
+    builder.add("door", 120);
+    builder.save("words.idx");
+    const auto index = PrefixIndex::open("words.idx");
+    for (const auto& match : index.topK("do", 10)) std::cout << match.word;
+
+C++17, POSIX
+
+*/
+
+#ifndef PREFIX_INDEX_H
+#define PREFIX_INDEX_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+class PrefixIndex {
+ public:
+    struct Match {
+        std::string_view word;
+        uint32_t score;
+    };
+
+    // positions [first, last) in the sorted words
+    struct Range {
+        size_t first;
+        size_t last;
+        size_t size() const { return last - first; }
+        bool empty() const { return first == last; }
+    };
+
+    class Builder {
+     public:
+        // a word added twice keeps its best score
+        void add(std::string_view word, uint32_t score) {
+            if (word.find('\0') != std::string_view::npos) throw std::invalid_argument{"PrefixIndex: word with a '\\0'"};
+            m_words.emplace_back(std::string{word}, score);
+        }
+
+        std::vector<char> build();
+        PrefixIndex index() { return PrefixIndex{std::make_shared<std::vector<char>>(build())}; }
+        void save(const std::string& path);
+
+     private:
+        std::vector<std::pair<std::string, uint32_t>> m_words;
+    };
+
+    static PrefixIndex open(const std::string& path);
+
+    Range range(std::string_view prefix) const;
+
+    // the words of the range in order, at most limit of them
+    std::vector<std::string_view> complete(std::string_view prefix, size_t limit = SIZE_MAX) const {
+        const auto found = range(prefix);
+        std::vector<std::string_view> words;
+        for (size_t i = found.first; i < found.last && words.size() < limit; ++i) words.push_back(word(i));
+        return words;
+    }
+
+    // best score first, the first in alphabetical order for equal scores
+    std::vector<Match> topK(std::string_view prefix, size_t k) const;
+
+    std::string_view word(size_t i) const { return {m_pool + m_offsets[i], m_offsets[i + 1] - m_offsets[i]}; }
+    uint32_t score(size_t i) const { return m_scores[i]; }
+    size_t size() const { return m_count; }
+
+ private:
+    static constexpr char kMagic[8] = {'P', 'R', 'F', 'X', 'I', 'D', 'X', '1'};
+    static constexpr size_t kBuckets = 1 << 16;     // first 2 bytes
+    static constexpr size_t kBlock = 64;            // words per block of the sparse table
+
+    struct Header {
+        char magic[8];
+        uint64_t count;
+        uint64_t poolBytes;
+        uint64_t blocks;
+        uint64_t levels;
+    };
+
+    // section sizes in bytes, each one rounded to 8
+    struct Layout {
+        size_t buckets, offsets, scores, table, pool, total;
+
+        explicit Layout(const Header& header) {
+            auto round = [](size_t bytes) { return (bytes + 7) / 8 * 8; };
+            buckets = round((kBuckets + 1) * sizeof(uint32_t));
+            offsets = round((header.count + 1) * sizeof(uint32_t));
+            scores = round(header.count * sizeof(uint32_t));
+            table = round(header.levels * header.blocks * sizeof(uint32_t));
+            pool = round(header.poolBytes);
+            total = sizeof(Header) + buckets + offsets + scores + table + pool;
+        }
+    };
+
+    explicit PrefixIndex(std::shared_ptr<const std::vector<char>> buffer)
+    :PrefixIndex{buffer, buffer->data(), buffer->size()} {}
+
+    PrefixIndex(std::shared_ptr<const void> owner, const char* data, size_t size);
+
+    static size_t bucketOf(std::string_view word) {
+        const auto byte = [word](size_t i) { return i < word.size() ? static_cast<unsigned char>(word[i]) : 0u; };
+        return byte(0) << 8 | byte(1);
+    }
+
+    // the word with the best score of [first, last), first of them on equal scores
+    size_t best(size_t first, size_t last) const;
+    size_t better(size_t lhs, size_t rhs) const {
+        return m_scores[rhs] > m_scores[lhs] || (m_scores[rhs] == m_scores[lhs] && rhs < lhs) ? rhs : lhs;
+    }
+    size_t bestOfBlocks(size_t firstBlock, size_t lastBlock) const;
+
+    std::shared_ptr<const void> m_owner;    // the buffer or the mapping
+    size_t m_count = 0;
+    size_t m_blocks = 0;
+    const uint32_t* m_buckets = nullptr;
+    const uint32_t* m_offsets = nullptr;
+    const uint32_t* m_scores = nullptr;
+    const uint32_t* m_table = nullptr;      // level l: best word of the blocks [b, b + 2^l)
+    const char* m_pool = nullptr;
+};
+
+
+inline std::vector<char> PrefixIndex::Builder::build()
+{
+    std::sort(m_words.begin(), m_words.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.first < rhs.first || (lhs.first == rhs.first && lhs.second > rhs.second);
+    });
+    m_words.erase(std::unique(m_words.begin(), m_words.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.first == rhs.first;
+    }), m_words.end());
+
+    Header header{};
+    std::memcpy(header.magic, kMagic, sizeof kMagic);
+    header.count = m_words.size();
+    for (const auto& [word, score] : m_words) header.poolBytes += word.size();
+    if (header.poolBytes > UINT32_MAX) throw std::length_error{"PrefixIndex: more than 4GB of words"};
+    header.blocks = (header.count + kBlock - 1) / kBlock;
+    while ((size_t{1} << header.levels) <= header.blocks) ++header.levels;
+    const Layout layout{header};
+
+    std::vector<char> buffer(layout.total);
+    std::memcpy(buffer.data(), &header, sizeof header);
+    auto section = [&buffer](size_t offset) { return reinterpret_cast<uint32_t*>(buffer.data() + offset); };
+    uint32_t* buckets = section(sizeof header);
+    uint32_t* offsets = section(sizeof header + layout.buckets);
+    uint32_t* scores = section(sizeof header + layout.buckets + layout.offsets);
+    uint32_t* table = section(sizeof header + layout.buckets + layout.offsets + layout.scores);
+    char* pool = buffer.data() + sizeof header + layout.buckets + layout.offsets + layout.scores + layout.table;
+
+    // buckets[b] = first word of bucket b or after
+    size_t bucket = 0;
+    uint32_t offset = 0;
+    for (size_t i = 0; i < m_words.size(); ++i) {
+        const auto& [word, score] = m_words[i];
+        for (const size_t b = bucketOf(word); bucket <= b; ++bucket) buckets[bucket] = static_cast<uint32_t>(i);
+        offsets[i] = offset;
+        scores[i] = score;
+        std::memcpy(pool + offset, word.data(), word.size());
+        offset += static_cast<uint32_t>(word.size());
+    }
+    for (; bucket <= kBuckets; ++bucket) buckets[bucket] = static_cast<uint32_t>(m_words.size());
+    offsets[m_words.size()] = offset;
+
+    auto better = [scores](uint32_t lhs, uint32_t rhs) { return scores[rhs] > scores[lhs] ? rhs : lhs; };
+    for (size_t b = 0; b < header.blocks; ++b) {
+        uint32_t best = static_cast<uint32_t>(b * kBlock);
+        for (size_t i = best + 1; i < std::min<size_t>((b + 1) * kBlock, header.count); ++i) best = better(best, i);
+        table[b] = best;
+    }
+    for (size_t level = 1; level < header.levels; ++level) {
+        uint32_t* current = table + level * header.blocks;
+        const uint32_t* previous = current - header.blocks;
+        const size_t half = size_t{1} << (level - 1);
+        for (size_t b = 0; b + 2 * half <= header.blocks; ++b) current[b] = better(previous[b], previous[b + half]);
+    }
+    m_words.clear();
+    return buffer;
+}
+
+inline void PrefixIndex::Builder::save(const std::string& path)
+{
+    const auto buffer = build();
+    std::ofstream file{path, std::ios::binary};
+    if (!file.write(buffer.data(), buffer.size())) throw std::runtime_error{"PrefixIndex: cannot write " + path};
+}
+
+inline PrefixIndex PrefixIndex::open(const std::string& path)
+{
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error{"PrefixIndex: cannot open " + path};
+    struct stat info{};
+    const bool sized = ::fstat(fd, &info) == 0 && info.st_size > 0;
+    void* data = sized ? ::mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+    ::close(fd);    // the mapping stays valid
+    if (data == MAP_FAILED) throw std::runtime_error{"PrefixIndex: cannot map " + path};
+    const size_t size = info.st_size;
+    std::shared_ptr<const void> mapping{data, [size](const void* ptr) { ::munmap(const_cast<void*>(ptr), size); }};
+    return PrefixIndex{std::move(mapping), static_cast<const char*>(data), size};
+}
+
+inline PrefixIndex::PrefixIndex(std::shared_ptr<const void> owner, const char* data, size_t size)
+:m_owner{std::move(owner)}
+{
+    Header header;
+    if (size < sizeof header) throw std::runtime_error{"PrefixIndex: truncated file"};
+    std::memcpy(&header, data, sizeof header);
+    if (std::memcmp(header.magic, kMagic, sizeof kMagic) != 0) throw std::runtime_error{"PrefixIndex: not an index"};
+    const Layout layout{header};
+    if (layout.total != size) throw std::runtime_error{"PrefixIndex: truncated file"};
+
+    m_count = header.count;
+    m_blocks = header.blocks;
+    m_buckets = reinterpret_cast<const uint32_t*>(data + sizeof header);
+    m_offsets = reinterpret_cast<const uint32_t*>(data + sizeof header + layout.buckets);
+    m_scores = reinterpret_cast<const uint32_t*>(data + sizeof header + layout.buckets + layout.offsets);
+    m_table = reinterpret_cast<const uint32_t*>(data + sizeof header + layout.buckets + layout.offsets + layout.scores);
+    m_pool = data + sizeof header + layout.buckets + layout.offsets + layout.scores + layout.table;
+    if (m_offsets[m_count] != header.poolBytes) throw std::runtime_error{"PrefixIndex: corrupted file"};
+}
+
+inline PrefixIndex::Range PrefixIndex::range(std::string_view prefix) const
+{
+    if (prefix.empty()) return {0, m_count};
+    const size_t bucket = bucketOf(prefix);
+    // 1 byte: all the buckets of this first byte. 2 bytes: exactly one bucket
+    const size_t lastBucket = prefix.size() == 1 ? bucket + 256 : bucket + 1;
+    Range found{m_buckets[bucket], m_buckets[lastBucket]};
+    if (prefix.size() <= 2 || found.empty()) return found;
+
+    // binary searches on the first prefix.size() bytes of the words
+    auto wordPrefix = [this, n = prefix.size()](size_t i) { return word(i).substr(0, n); };
+    size_t first = found.first, count = found.size();
+    while (count > 0) {     // lower bound
+        const size_t half = count / 2;
+        if (wordPrefix(first + half) < prefix) {
+            first += half + 1;
+            count -= half + 1;
+        }
+        else {
+            count = half;
+        }
+    }
+    size_t last = first;
+    count = found.last - first;
+    while (count > 0) {     // upper bound
+        const size_t half = count / 2;
+        if (wordPrefix(last + half) == prefix) {
+            last += half + 1;
+            count -= half + 1;
+        }
+        else {
+            count = half;
+        }
+    }
+    return {first, last};
+}
+
+inline size_t PrefixIndex::bestOfBlocks(size_t firstBlock, size_t lastBlock) const
+{
+    size_t level = 0;
+    while ((size_t{2} << level) <= lastBlock - firstBlock) ++level;
+    const uint32_t* row = m_table + level * m_blocks;
+    return better(row[firstBlock], row[lastBlock - (size_t{1} << level)]);
+}
+
+inline size_t PrefixIndex::best(size_t first, size_t last) const
+{
+    const size_t firstFull = (first + kBlock - 1) / kBlock;
+    const size_t lastFull = last / kBlock;
+    size_t result = first;
+    if (firstFull >= lastFull) {
+        for (size_t i = first + 1; i < last; ++i) result = better(result, i);
+        return result;
+    }
+    result = bestOfBlocks(firstFull, lastFull);
+    for (size_t i = first; i < firstFull * kBlock; ++i) result = better(result, i);
+    for (size_t i = lastFull * kBlock; i < last; ++i) result = better(result, i);
+    return result;
+}
+
+inline std::vector<PrefixIndex::Match> PrefixIndex::topK(std::string_view prefix, size_t k) const
+{
+    struct Candidate {
+        size_t best, first, last;
+    };
+    auto worse = [this](const Candidate& lhs, const Candidate& rhs) { return better(lhs.best, rhs.best) == rhs.best; };
+    std::priority_queue<Candidate, std::vector<Candidate>, decltype(worse)> candidates{worse};
+    const auto found = range(prefix);
+    if (!found.empty()) candidates.push({best(found.first, found.last), found.first, found.last});
+
+    std::vector<Match> matches;
+    while (matches.size() < k && !candidates.empty()) {
+        const auto [i, first, last] = candidates.top();
+        candidates.pop();
+        matches.push_back({word(i), m_scores[i]});
+        if (first < i) candidates.push({best(first, i), first, i});
+        if (i + 1 < last) candidates.push({best(i + 1, last), i + 1, last});
+    }
+    return matches;
+}
+
+#endif // PREFIX_INDEX_H
@@ -3,13 +3,17 @@
 #include <algorithm>
 #include <vector>
 #include <functional>
+#include "../common/out_sink.h"
+#include "parallel_sort.h"
 
 template<typename T>
-void display(T cont) {
-    for_each(cont.cbegin(), cont.cend(), [&cont](const auto &elem) {
+void display(const T& cont) {
+    auto& out = output::stdoutSink();
+    for_each(cont.cbegin(), cont.cend(), [&out](const auto &elem) {
         const auto&[name, age] = elem; 
-        std::cout << "[ " << name << ":" << age << " ]" << "\n";
+        out << "[ " << name << ":" << age << " ]" << "\n";
     });
+    out.flush();
 }
 
 
@@ -91,4 +95,13 @@ int main() {
     std::cout << "\n slide to the end [][][][*][*][] -> [][][][][*][*] \n";
     display(record);
 
+    // 2.7 same signature as quickSort, on all the cores (parallel_sort.cpp for millions of people)
+    parallel::sort(record.begin(), record.end(), [](const auto& lhs, const auto& rhs){return lhs.name < rhs.name;});
+    std::cout << "\n parallel::sort using name \n";
+    display(record);
+
+    parallel::radixSort(record.begin(), record.end(), [](const People& people){return people.age;});
+    std::cout << "\n parallel::radixSort using age: stable, Arthur stays before Rene \n";
+    display(record);
+
 }
\ No newline at end of file
@@ -0,0 +1,91 @@
+/*
+
+lower_bound on sorted int arrays from 4KB (L1) to 256MB (DRAM), ns per search of a random key:
+ - std::lower_bound
+ - binarySearch: search::binarySearch, the textbook loop of binary_search.cpp (exact match only)
+ - branchless: search::lowerBound, conditional move and prefetch of both next probes
+ - Eytzinger: search::Eytzinger, breadth first layout, prefetch 4 levels ahead
+ - B-tree: search::StaticBTree, 16 keys per cache line compared with SSE2
+
+The searches are independent: the CPU overlaps the cache misses of consecutive searches when the next probe does not
+depend on a branch prediction, which is where the branchless versions win the most.
+
+1) g++ -std=c++17 -O2 -Wall -pedantic search.cpp -o search
+2) ./search 67108864    // from 1K up to 64M ints (default 16M)
+
+*/
+
+#include "search.h"
+#include "../common/bench.h"
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <cassert>
+
+void benchmark(size_t size, const std::vector<int>& queries)
+{
+    std::vector<int> sorted(size);
+    for (size_t i = 0; i < size; ++i) sorted[i] = static_cast<int>(2 * i + 1);     // odd keys: half the queries miss
+    const search::Eytzinger<int> eytzinger{sorted};
+    const search::StaticBTree<int> btree{sorted};
+
+    // same answer everywhere, size when not found
+    size_t expected = 0;
+    for (int key : queries) expected += std::lower_bound(sorted.begin(), sorted.end(), key) - sorted.begin();
+    auto total = [&](auto&& lowerBound) {
+        size_t sum = 0;
+        for (int key : queries) sum += lowerBound(key).value_or(size);
+        return sum;
+    };
+    size_t sum = 0;
+    const auto stdNs = bench::nsPerOp(queries.size(), [&] {
+        for (int key : queries) sum += std::lower_bound(sorted.begin(), sorted.end(), key) - sorted.begin();
+    });
+    const auto textbookNs = bench::nsPerOp(queries.size(), [&] {
+        for (int key : queries) sum += search::binarySearch(sorted, key) - sorted.begin();
+    });
+    size_t branchless = 0, eytz = 0, tree = 0;
+    const auto branchlessNs = bench::nsPerOp(queries.size(), [&] { branchless = total([&](int key) { return search::lowerBound(sorted, key); }); });
+    const auto eytzingerNs = bench::nsPerOp(queries.size(), [&] { eytz = total([&](int key) { return eytzinger.lowerBound(key); }); });
+    const auto btreeNs = bench::nsPerOp(queries.size(), [&] { tree = total([&](int key) { return btree.lowerBound(key); }); });
+    assert(branchless == expected && eytz == expected && tree == expected);
+    bench::keep(sum + branchless + eytz + tree);
+
+    std::cout << std::setw(10) << size << std::setw(10) << size * sizeof(int) / 1024 << "KB"
+              << std::setw(9) << stdNs << std::setw(10) << textbookNs << std::setw(11) << branchlessNs
+              << std::setw(10) << eytzingerNs << std::setw(9) << btreeNs << "\n";
+}
+
+int main(int argc, char* argv[])
+{
+    // 1. every layout gives the position of the first element not < key
+    const std::vector<int> v4 {0, 1, 2, 3, 4, 5, 6, 7, 8, 10};
+    const search::Eytzinger<int> eytzinger{v4};
+    const search::StaticBTree<int> btree{v4};
+    for (int key = -1; key <= 11; ++key) {
+        const auto expected = std::lower_bound(v4.begin(), v4.end(), key) - v4.begin();
+        const auto position = search::lowerBound(v4, key);
+        assert(position.value_or(v4.size()) == static_cast<size_t>(expected));
+        assert(eytzinger.lowerBound(key) == position && btree.lowerBound(key) == position);
+    }
+    if (auto position = eytzinger.lowerBound(9)) std::cout << "lowerBound(9): " << v4[*position] << " at " << *position << "\n";
+    if (!btree.lowerBound(11)) std::cout << "lowerBound(11): none\n";
+    std::cout << "\n";
+
+    // 2. benchmark
+    const size_t maxSize = argc > 1 ? std::stoul(argv[1]) : 16 * 1024 * 1024;
+    std::mt19937 gen{42};
+    std::uniform_int_distribution<int> dist{0, static_cast<int>(2 * maxSize)};
+    std::vector<int> queries(1'000'000);
+    for (auto& key : queries) key = dist(gen);
+
+    std::cout << "      size      bytes  std::lower_bound  textbook  branchless  Eytzinger  B-tree  (ns/search)\n";
+    for (size_t size = 1024; size <= maxSize; size *= 4) {
+        // keys spread over the whole array
+        for (auto& key : queries) key = dist(gen) % static_cast<int>(2 * size + 2);
+        benchmark(size, queries);
+    }
+}
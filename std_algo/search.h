@@ -0,0 +1,325 @@
+/*
+
+lower_bound on big static sorted arrays: the first element not < key, as a position in the sorted order,
+std::nullopt if all the elements are < key (like findElem of optional.cpp).
+
+std::lower_bound halves the range with a branch the CPU cannot predict, and every probe of a big array is a
+cache miss that must complete before the next address is known. Three ways around it:
+ - lowerBound(): branchless, the next probe is a conditional move. Both possible next probes are prefetched.
+   lowerBounds() searches a whole batch of keys, interleaved or sorted first.
+ - Eytzinger: the array stored in breadth first order (node k has children 2k and 2k+1). The first levels share
+   a few cache lines that stay hot, and the 16 descendants 4 levels below k are contiguous: one prefetch
+   fetches them while the 4 levels in between are searched.
+ - StaticBTree: nodes of 64 bytes (16 ints) with 17 children each. One node is one cache line and all its keys are
+   compared at once (SSE2 for int32_t), so the tree has log17(n) levels instead of log2(n).
+
+binarySearch() is the textbook loop of binary_search.cpp (an iterator to an equal element, or end()), kept here
+as the baseline of the benchmarks.
+
+Eytzinger and StaticBTree copy the sorted input once into their own layout, plus the rank of every slot
+(uint32_t): up to 4G elements, for arithmetic types.
+
+    const search::Eytzinger<int> table{sortedVec};
+    if (auto position = table.lowerBound(42)) sortedVec[*position];
+    auto positions = search::lowerBounds(sortedVec, keys);     // one std::optional per key
+
+C++17
+
+*/
+
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace search {
+
+constexpr size_t kCacheLine = 64;
+
+namespace detail {
+
+struct Free { void operator()(void* ptr) const { std::free(ptr); } };
+
+template<typename T>
+using AlignedArray = std::unique_ptr<T[], Free>;
+
+template<typename T>
+AlignedArray<T> allocateAligned(size_t count)
+{
+    const size_t bytes = (std::max<size_t>(count, 1) * sizeof(T) + kCacheLine - 1) / kCacheLine * kCacheLine;
+    auto data = static_cast<T*>(std::aligned_alloc(kCacheLine, bytes));
+    if (data == nullptr) throw std::bad_alloc{};
+    return AlignedArray<T>{data};
+}
+
+// a prefetch is only a hint: computed on integers, the address may be past the end
+template<typename T>
+inline void prefetch(const T* base, size_t index)
+{
+    __builtin_prefetch(reinterpret_cast<const void*>(reinterpret_cast<uintptr_t>(base) + index * sizeof(T)));
+}
+
+template<typename T>
+void checkSize(size_t size)
+{
+    static_assert(std::is_arithmetic_v<T>, "search: arithmetic keys only");
+    if (size >= std::numeric_limits<uint32_t>::max()) throw std::length_error{"search: more than 4G elements"};
+}
+
+} // namespace detail
+
+
+// 0. The textbook binary search of binary_search.cpp: exact match only, seq.end() if elem is not there
+
+template<typename T, typename K>
+const typename T::iterator binarySearch(T& seq, const K elem) {
+    auto first = seq.begin();
+    auto last = seq.end();
+    if (first == last || elem < *first || elem > *std::prev(last)) return seq.end();
+
+    while (first < last) {
+        auto const N = std::distance(first, last);
+        auto const pivot = std::next(first, N / 2);
+        if (elem == *pivot) {
+            return (pivot);
+        }
+        else if (elem < *pivot) {
+            last = pivot;
+        }
+        else {
+            first = std::next(pivot);   // pivot is already checked: first = pivot never moves on 1 element
+        }
+    }
+    return seq.end();
+}
+
+
+// 1. Branchless binary search on the sorted array itself
+
+template<typename T>
+std::optional<size_t> lowerBound(const T* data, size_t size, const T& key)
+{
+    if (size == 0) return std::nullopt;
+    const T* base = data;
+    size_t len = size;
+    while (len > 1) {
+        const size_t half = len / 2;
+        detail::prefetch(base, half / 2);           // next probe if base stays
+        detail::prefetch(base, half + half / 2);    // next probe if base moves
+        base += (base[half - 1] < key) * half;     // arithmetic: GCC turns the ?: into a branch
+        len -= half;
+    }
+    const size_t position = (base - data) + (*base < key);
+    return position < size ? std::optional<size_t>{position} : std::nullopt;
+}
+
+template<typename T>
+std::optional<size_t> lowerBound(const std::vector<T>& sorted, const T& key)
+{
+    return lowerBound(sorted.data(), sorted.size(), key);
+}
+
+
+// 2. Many keys at once on the sorted array
+
+// Interleaved: the branchless searches of kGroup keys advance together, one level at a time. Every search knows
+// its next probe right after its comparison and prefetches it: the cache misses of the group overlap instead of
+// following each other. SortedSweep: the keys are sorted first, each search then starts where the previous one
+// ended and gallops forward (O(log distance)), the array is read once in order.
+enum class Batch { Interleaved, SortedSweep };
+
+template<typename T>
+void lowerBounds(const T* data, size_t size, const T* keys, size_t count, std::optional<size_t>* results,
+                 Batch mode = Batch::Interleaved)
+{
+    if (mode == Batch::SortedSweep) {
+        // the keys are copied next to their index: the sort compares contiguous pairs, not keys[index]
+        std::vector<std::pair<T, size_t>> order(count);
+        for (size_t i = 0; i < count; ++i) order[i] = {keys[i], i};
+        std::sort(order.begin(), order.end());
+        size_t first = 0;   // every element before first is < the current key
+        for (const auto& [key, index] : order) {
+            size_t last = first;
+            for (size_t step = 1; last < size && data[last] < key; step *= 2) {
+                first = last + 1;
+                last += step;
+            }
+            first = std::lower_bound(data + first, data + std::min(last, size), key) - data;
+            results[index] = first < size ? std::optional<size_t>{first} : std::nullopt;
+        }
+        return;
+    }
+
+    constexpr size_t kGroup = 16;
+    const T* base[kGroup];
+    for (size_t group = 0; group < count; group += kGroup) {
+        const size_t n = std::min(kGroup, count - group);
+        const T* key = keys + group;
+        if (size == 0) {
+            std::fill(results + group, results + group + n, std::nullopt);
+            continue;
+        }
+        std::fill(base, base + n, data);
+        for (size_t len = size; len > 1; ) {
+            const size_t half = len / 2;
+            len -= half;
+            const size_t next = len / 2;    // next probe at base[next - 1]
+            for (size_t i = 0; i < n; ++i) {
+                base[i] += (base[i][half - 1] < key[i]) * half;
+                detail::prefetch(base[i], next - 1);
+            }
+        }
+        for (size_t i = 0; i < n; ++i) {
+            const size_t position = (base[i] - data) + (*base[i] < key[i]);
+            results[group + i] = position < size ? std::optional<size_t>{position} : std::nullopt;
+        }
+    }
+}
+
+template<typename T>
+std::vector<std::optional<size_t>> lowerBounds(const std::vector<T>& sorted, const std::vector<T>& keys,
+                                               Batch mode = Batch::Interleaved)
+{
+    std::vector<std::optional<size_t>> results(keys.size());
+    lowerBounds(sorted.data(), sorted.size(), keys.data(), keys.size(), results.data(), mode);
+    return results;
+}
+
+
+// 3. Eytzinger layout (breadth first order)
+
+template<typename T>
+class Eytzinger {
+ public:
+    static constexpr size_t kPerLine = kCacheLine / sizeof(T);
+
+    explicit Eytzinger(const std::vector<T>& sorted)
+    :m_size{sorted.size()},m_data{detail::allocateAligned<T>(m_size + 1)},m_rank{new uint32_t[m_size + 1]}
+    {
+        detail::checkSize<T>(m_size);
+        size_t next = 0;
+        fill(sorted, 1, next);
+        m_rank[0] = static_cast<uint32_t>(m_size);    // root of nothing: not found
+    }
+
+    std::optional<size_t> lowerBound(const T& key) const {
+        size_t k = 1;
+        while (k <= m_size) {
+            detail::prefetch(m_data.get(), k * kPerLine);     // 4 levels below for ints
+            k = 2 * k + (m_data[k] < key);
+        }
+        // k went right (bit 1) after the answer and then only left: drop those moves and the last left one
+        k >>= __builtin_ffsll(static_cast<long long>(~k));
+        const size_t position = m_rank[k];
+        return position < m_size ? std::optional<size_t>{position} : std::nullopt;
+    }
+
+    size_t size() const { return m_size; }
+
+ private:
+    // in order walk of the implicit tree gives the sorted order
+    void fill(const std::vector<T>& sorted, size_t k, size_t& next) {
+        if (k > m_size) return;
+        fill(sorted, 2 * k, next);
+        m_rank[k] = static_cast<uint32_t>(next);
+        m_data[k] = sorted[next++];
+        fill(sorted, 2 * k + 1, next);
+    }
+
+    size_t m_size;
+    detail::AlignedArray<T> m_data;         // m_data[0] unused, root at 1
+    std::unique_ptr<uint32_t[]> m_rank;     // position in the sorted order of each slot
+};
+
+
+// 4. B-tree layout: one node per cache line
+
+template<typename T>
+class StaticBTree {
+ public:
+    static constexpr size_t kKeys = kCacheLine / sizeof(T);     // 16 ints per node, 17 children
+
+    explicit StaticBTree(const std::vector<T>& sorted)
+    :m_size{sorted.size()},m_nodes{(m_size + kKeys - 1) / kKeys},
+     m_keys{detail::allocateAligned<T>(m_nodes * kKeys)},m_rank{new uint32_t[m_nodes * kKeys + 1]}
+    {
+        detail::checkSize<T>(m_size);
+        size_t next = 0;
+        fill(sorted, 0, next);
+        m_rank[m_nodes * kKeys] = static_cast<uint32_t>(m_size);
+    }
+
+    std::optional<size_t> lowerBound(const T& key) const {
+        size_t slot = m_nodes * kKeys;      // rank m_size
+        size_t node = 0;
+        while (node < m_nodes) {
+            const size_t i = countLess(m_keys.get() + node * kKeys, key);
+            // first key >= key in this node, deeper is smaller. The rank is only read at the end: one cache miss
+            slot = i < kKeys ? node * kKeys + i : slot;
+            node = child(node, i);
+        }
+        const size_t position = m_rank[slot];
+        return position < m_size ? std::optional<size_t>{position} : std::nullopt;
+    }
+
+    size_t size() const { return m_size; }
+
+ private:
+    static size_t child(size_t node, size_t i) { return node * (kKeys + 1) + i + 1; }
+
+    // the keys of a node are sorted: the number of keys < key is the child to go to
+    static size_t countLess(const T* keys, const T& key) {
+#if defined(__SSE2__)
+        if constexpr (std::is_same_v<T, int32_t>) {
+            const __m128i needle = _mm_set1_epi32(key);
+            const auto block = reinterpret_cast<const __m128i*>(keys);
+            const __m128i less01 = _mm_packs_epi32(_mm_cmpgt_epi32(needle, _mm_load_si128(block)),
+                                                   _mm_cmpgt_epi32(needle, _mm_load_si128(block + 1)));
+            const __m128i less23 = _mm_packs_epi32(_mm_cmpgt_epi32(needle, _mm_load_si128(block + 2)),
+                                                   _mm_cmpgt_epi32(needle, _mm_load_si128(block + 3)));
+            return __builtin_popcount(_mm_movemask_epi8(_mm_packs_epi16(less01, less23)));
+        }
+#endif
+        size_t count = 0;
+        for (size_t i = 0; i < kKeys; ++i) count += keys[i] < key;
+        return count;
+    }
+
+    // in order walk: keys of child i, then key i. The last node is padded with the biggest value and the rank
+    // m_size, found only if every key is smaller
+    void fill(const std::vector<T>& sorted, size_t node, size_t& next) {
+        if (node >= m_nodes) return;
+        for (size_t i = 0; i < kKeys; ++i) {
+            fill(sorted, child(node, i), next);
+            const size_t slot = node * kKeys + i;
+            const bool real = next < m_size;
+            m_keys[slot] = real ? sorted[next] : std::numeric_limits<T>::max();
+            m_rank[slot] = static_cast<uint32_t>(real ? next++ : m_size);
+        }
+        fill(sorted, child(node, kKeys), next);
+    }
+
+    size_t m_size;
+    size_t m_nodes;
+    detail::AlignedArray<T> m_keys;
+    std::unique_ptr<uint32_t[]> m_rank;
+};
+
+} // namespace search
+
+#endif // SEARCH_H
@@ -0,0 +1,141 @@
+/*
+
+startFromWord of main.cpp on a big log file (default 1 GB of random words, the word is near the end), ms:
+ - std::string: the whole file read into a std::string (ifstream), then startFromWord
+ - MappedFile: the file mapped (mapped_file.h), startFromWord on the view, no copy. With the Sequential (default),
+   Random and Normal hints and with populate (the whole file read at open)
+Cold: the pages of the file are dropped from the page cache first (posix_fadvise), warm: they are all in memory.
+
+1) g++ -std=c++17 -O2 -Wall -pedantic mapped_file.cpp -o mapped_file
+2) ./mapped_file 4096 /tmp/big.log    // 4 GB file, created if it is not there (default 1024 MB, /tmp/mapped_file.log)
+
+Built with -DNDEBUG the views are plain std::string_view, without it they are counted (see mapped_file.h).
+
+*/
+
+#include "mapped_file.h"
+#include "../common/bench.h"
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <random>
+#include <cassert>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+constexpr std::string_view kWord = "the online meeting starts now";
+
+std::string_view startFromWord(std::string_view str, std::string_view word) {
+    return str.substr(std::min(str.find(word), str.size())); // substr creates now only a new view
+}
+
+// lines of random words, kWord at the end
+void createLog(const std::string& path, size_t size)
+{
+    std::mt19937 gen{42};
+    std::uniform_int_distribution<int> letter{'a', 'z'};
+    std::uniform_int_distribution<size_t> length{3, 10};
+    std::vector<std::string> vocabulary(5000);
+    for (auto& word : vocabulary) {
+        word.resize(length(gen));
+        for (auto& c : word) c = static_cast<char>(letter(gen));
+    }
+    std::uniform_int_distribution<size_t> pickWord{0, vocabulary.size() - 1};
+    std::ofstream file{path, std::ios::binary};
+    std::string block;
+    for (size_t written = 0, words = 1; written < size; written += block.size()) {
+        block.clear();
+        while (block.size() < (1 << 20)) {
+            block += vocabulary[pickWord(gen)];
+            block += words++ % 12 == 0 ? '\n' : ' ';
+        }
+        file.write(block.data(), block.size());
+    }
+    file << kWord << '\n';
+    if (!file) throw std::runtime_error{"cannot write " + path};
+}
+
+void dropFromCache(const std::string& path)
+{
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    ::fdatasync(fd);
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    ::close(fd);
+}
+
+std::string readAll(const std::string& path)
+{
+    std::ifstream file{path, std::ios::binary};
+    std::string content;
+    file.seekg(0, std::ios::end);
+    content.resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(content.data(), content.size());
+    return content;
+}
+
+int main(int argc, char* argv[])
+{
+    // 1. a view on a small file
+    const std::string hello = "/tmp/mapped_file_hello.txt";
+    std::ofstream{hello} << "Hello Guys " << kWord << "\n";
+    {
+        const auto file = MappedFile::open(hello);
+        const MappedFile::View content = file.view();
+        std::cout << startFromWord(content, "the online");
+        const MappedFile::View guys = content.subview(6, 4);
+        std::cout << guys << ", " << file.size() << " bytes, huge pages hint " << (file.hugePages() ? "accepted" : "not available") << "\n\n";
+    }   // the views are destroyed before the file, in the reverse order of their declaration
+
+    // 2. benchmark
+    const size_t megabytes = argc > 1 ? std::stoul(argv[1]) : 1024;
+    const std::string path = argc > 2 ? argv[2] : "/tmp/mapped_file.log";
+    if (std::ifstream existing{path, std::ios::binary | std::ios::ate}; !existing || static_cast<size_t>(existing.tellg()) < megabytes * 1'000'000) {
+        existing.close();
+        std::cout << "creating " << path << "...\n";
+        createLog(path, megabytes * 1'000'000);
+    }
+
+    using Options = MappedFile::Options;
+    using Access = MappedFile::Access;
+    const std::pair<const char*, Options> mappings[] = {
+        {"MappedFile sequential", Options{Access::Sequential, true, false}},
+        {"MappedFile random", Options{Access::Random, true, false}},
+        {"MappedFile normal", Options{Access::Normal, true, false}},
+        {"MappedFile populate", Options{Access::Sequential, true, true}},
+    };
+
+    const size_t fileSize = MappedFile::open(path).size();
+    size_t expected = 0;
+    std::cout << "                            cold ms   warm ms   MB copied\n";
+    auto run = [&](const char* name, auto&& search, size_t copied) {
+        std::cout << std::setw(24) << name << std::fixed << std::setprecision(0);
+        for (bool cold : {true, false}) {
+            if (cold) dropFromCache(path);
+            size_t found = 0;
+            std::cout << std::setw(10) << bench::msFor([&] { found = search(); });
+            assert(expected == 0 || found == expected);
+            expected = found;
+        }
+        std::cout << std::setw(12) << copied / 1e6 << "\n";
+    };
+
+    run("std::string", [&] {
+        const std::string content = readAll(path);
+        return startFromWord(content, kWord).size();
+    }, fileSize);
+    for (const auto& [name, options] : mappings) {
+        run(name, [&, &options = options] {
+            const auto file = MappedFile::open(path, options);
+            return startFromWord(file.view(), kWord).size();
+        }, 0);
+    }
+    assert(expected == kWord.size() + 1);
+    std::cout << "\n" << fileSize / 1e6 << " MB, \"" << kWord << "\" found " << expected << " bytes before the end\n";
+}
@@ -0,0 +1,202 @@
+/*
+
+MappedFile: a read-only file mapped in memory (mmap), its content handed out as string_view without any copy.
+
+    const auto file = MappedFile::open("server.log");
+    MappedFile::View content = file.view();
+    std::string_view fromError = startFromWord(content, "error");
+
+The kernel loads the pages when they are first read, and madvise tells it how:
+ - Access::Sequential: reads far ahead and drops the pages behind (a scan of the whole file)
+ - Access::Random: no read ahead (lookups here and there)
+ - Options::hugePages: MADV_HUGEPAGE where the kernel has it (2MB pages, far fewer TLB misses on a multi-GB file).
+   Only a hint: most file systems keep 4KB pages for the page cache, hugePages() tells if the kernel accepted it
+ - Options::populate: MAP_POPULATE, the whole file is read at open instead of on the first accesses
+ - willNeed(offset, length): starts reading a range in the background
+
+Lifetime: a view is only valid while its MappedFile lives (it is moveable, the views follow the mapping).
+In debug builds (without NDEBUG):
+ - View counts itself in the MappedFile: destroying a MappedFile while Views are alive aborts with a message
+ - a file of up to kGuardBytes (16MB) is not unmapped but remapped with no access (PROT_NONE): reading a
+   std::string_view taken from a View after its MappedFile is gone crashes at once, instead of reading whatever
+   is mapped there later. This guard region is never released: each small file opened keeps its size of address
+   space reserved (no memory) until the process exits. Bigger files are unmapped, without this check
+In release builds View is a plain std::string_view.
+
+C++17
+
+*/
+
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+class MappedFile {
+    struct Tracker;
+
+ public:
+    static constexpr size_t kGuardBytes = size_t{1} << 24;     // debug builds: bigger files are really unmapped
+
+    enum class Access { Normal, Sequential, Random };
+
+    struct Options {
+        Access access = Access::Sequential;
+        bool hugePages = true;
+        bool populate = false;
+    };
+
+    // a std::string_view into the mapping (counted in debug builds)
+    class View : public std::string_view {
+     public:
+        View() = default;
+#ifndef NDEBUG
+        View(std::string_view view, Tracker* tracker):std::string_view{view},m_tracker{tracker} { retain(); }
+        View(const View& other):std::string_view{other},m_tracker{other.m_tracker} { retain(); }
+        View& operator=(const View& other) {
+            View copy{other};
+            swap(copy);
+            return *this;
+        }
+        ~View() { if (m_tracker) m_tracker->views.fetch_sub(1, std::memory_order_relaxed); }
+        void swap(View& other) noexcept {
+            std::swap(static_cast<std::string_view&>(*this), static_cast<std::string_view&>(other));
+            std::swap(m_tracker, other.m_tracker);
+        }
+#else
+        View(std::string_view view, Tracker*):std::string_view{view} {}
+#endif
+
+        // a part of the view, still a View
+        View subview(size_t pos, size_t count = npos) const { return {substr(pos, count), tracker()}; }
+
+     private:
+#ifndef NDEBUG
+        void retain() { if (m_tracker) m_tracker->views.fetch_add(1, std::memory_order_relaxed); }
+        Tracker* tracker() const { return m_tracker; }
+        Tracker* m_tracker = nullptr;
+#else
+        Tracker* tracker() const { return nullptr; }
+#endif
+    };
+
+    MappedFile() = default;
+    MappedFile(MappedFile&& other) noexcept { swap(other); }
+    MappedFile& operator=(MappedFile&& other) noexcept {
+        MappedFile moved{std::move(other)};
+        swap(moved);
+        return *this;
+    }
+    ~MappedFile() { release(); }
+
+    static MappedFile open(const std::string& path, Options options);
+    static MappedFile open(const std::string& path) { return open(path, Options{}); }
+
+    View view() const { return {{m_data, m_size}, m_tracker.get()}; }
+    View slice(size_t offset, size_t length) const { return view().subview(offset, length); }
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    bool hugePages() const { return m_hugePages; }
+
+    // another hint for the whole file, for example Random once the scan is done
+    void advise(Access access) const {
+        if (m_size > 0) ::madvise(const_cast<char*>(m_data), m_size, adviceFor(access));
+    }
+
+    // reads [offset, offset + length) in the background
+    void willNeed(size_t offset, size_t length) const {
+        if (offset >= m_size) return;
+        const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+        const size_t first = offset / page * page;
+        ::madvise(const_cast<char*>(m_data) + first, std::min(length, m_size - offset) + offset - first, MADV_WILLNEED);
+    }
+
+ private:
+    struct Tracker {
+        std::atomic<size_t> views{0};
+    };
+
+    static int adviceFor(Access access) {
+        switch (access) {
+            case Access::Sequential: return MADV_SEQUENTIAL;
+            case Access::Random: return MADV_RANDOM;
+            default: return MADV_NORMAL;
+        }
+    }
+
+    void swap(MappedFile& other) noexcept {
+        std::swap(m_data, other.m_data);
+        std::swap(m_size, other.m_size);
+        std::swap(m_hugePages, other.m_hugePages);
+        std::swap(m_tracker, other.m_tracker);
+    }
+
+    void release() {
+        if (m_size == 0) return;
+        void* data = const_cast<char*>(m_data);
+#ifndef NDEBUG
+        if (const size_t views = m_tracker->views.load(); views != 0) {
+            std::fprintf(stderr, "MappedFile: unmapped with %zu views still alive\n", views);
+            std::abort();
+        }
+        // keeps the addresses, without access: a dangling std::string_view crashes at its first read
+        if (m_size <= kGuardBytes &&
+            ::mmap(data, m_size, PROT_NONE, MAP_FIXED | MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0) != MAP_FAILED) return;
+#endif
+        ::munmap(data, m_size);
+    }
+
+    const char* m_data = nullptr;
+    size_t m_size = 0;
+    bool m_hugePages = false;
+    std::unique_ptr<Tracker> m_tracker = std::make_unique<Tracker>();
+};
+
+inline MappedFile MappedFile::open(const std::string& path, Options options)
+{
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error{"MappedFile: cannot open " + path};
+    struct stat info{};
+    if (::fstat(fd, &info) != 0) {
+        ::close(fd);
+        throw std::runtime_error{"MappedFile: cannot stat " + path};
+    }
+    MappedFile file;
+    file.m_size = static_cast<size_t>(info.st_size);
+    if (file.m_size == 0) {
+        ::close(fd);
+        return file;
+    }
+    int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+    if (options.populate) flags |= MAP_POPULATE;
+#endif
+    void* data = ::mmap(nullptr, file.m_size, PROT_READ, flags, fd, 0);
+    ::close(fd);    // the mapping stays valid
+    if (data == MAP_FAILED) {
+        file.m_size = 0;
+        throw std::runtime_error{"MappedFile: cannot map " + path};
+    }
+    file.m_data = static_cast<const char*>(data);
+#ifdef MADV_HUGEPAGE
+    if (options.hugePages) file.m_hugePages = ::madvise(data, file.m_size, MADV_HUGEPAGE) == 0;
+#endif
+    file.advise(options.access);
+    return file;
+}
+
+#endif // MAPPED_FILE_H
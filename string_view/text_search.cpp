@@ -0,0 +1,120 @@
+/*
+
+Searching a text of random words (default 64 MB, lines of 12 words) for all the matches, MB/s:
+ - one needle of 4 to 32 bytes: std::search, std::search with boyer_moore_searcher and
+   boyer_moore_horspool_searcher, std::string_view::find (startFromWord of main.cpp), text::Finder
+ - 10 to 500 words at once: text::Finder once per pattern, against text::MultiMatcher in one pass
+
+1) g++ -std=c++17 -O2 -Wall -pedantic text_search.cpp -o text_search
+2) ./text_search 256    // text of 256 MB (default 64)
+
+*/
+
+#include "text_search.h"
+#include "../common/bench.h"
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <optional>
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <cassert>
+
+std::string_view startFromWord(std::string_view str, std::string_view word) {
+    return str.substr(std::min(text::Finder{word}.find(str), str.size()));
+}
+
+// all the matches of std::search with a searcher, one after the other
+template<typename Searcher>
+size_t countAll(std::string_view text, const Searcher& searcher)
+{
+    size_t count = 0;
+    for (auto it = text.begin(); (it = std::search(it, text.end(), searcher)) != text.end(); ++it) ++count;
+    return count;
+}
+
+void benchmarkNeedle(std::string_view text, std::string_view needle)
+{
+    const double megabytes = text.size() / 1e6;
+    auto perSecond = [megabytes](double ms) { return megabytes / ms * 1000; };
+    size_t plain = 0, moore = 0, horspool = 0, find = 0, finder = 0;
+    const double plainMs = bench::msFor([&] {
+        for (auto it = text.begin(); (it = std::search(it, text.end(), needle.begin(), needle.end())) != text.end(); ++it) ++plain;
+    });
+    const double mooreMs = bench::msFor([&] { moore = countAll(text, std::boyer_moore_searcher{needle.begin(), needle.end()}); });
+    const double horspoolMs = bench::msFor([&] { horspool = countAll(text, std::boyer_moore_horspool_searcher{needle.begin(), needle.end()}); });
+    const double findMs = bench::msFor([&] {
+        for (size_t offset = text.find(needle); offset != std::string_view::npos; offset = text.find(needle, offset + 1)) ++find;
+    });
+    const double finderMs = bench::msFor([&] { finder = text::Finder{needle}.findAll(text).size(); });
+    assert(moore == plain && horspool == plain && find == plain && finder == plain);
+
+    std::cout << std::setw(7) << needle.size() << std::setw(9) << plain << std::fixed << std::setprecision(0)
+              << std::setw(13) << perSecond(plainMs) << std::setw(13) << perSecond(mooreMs)
+              << std::setw(10) << perSecond(horspoolMs) << std::setw(13) << perSecond(findMs)
+              << std::setw(14) << perSecond(finderMs) << "\n";
+}
+
+void benchmarkPatterns(std::string_view text, const std::vector<std::string>& patterns)
+{
+    const double megabytes = text.size() / 1e6;
+    size_t each = 0, once = 0;
+    const double eachMs = bench::msFor([&] {
+        for (const auto& pattern : patterns) each += text::Finder{pattern}.findAll(text).size();
+    });
+    std::optional<text::MultiMatcher> matcher;
+    const double buildMs = bench::msFor([&] { matcher.emplace(patterns); });
+    const double onceMs = bench::msFor([&] { once = matcher->count(text); });
+    assert(each == once);
+
+    std::cout << std::setw(9) << patterns.size() << std::setw(10) << once << std::fixed << std::setprecision(0)
+              << std::setw(14) << megabytes / eachMs * 1000 << std::setw(15) << megabytes / onceMs * 1000
+              << std::setw(9) << matcher->states() << std::setprecision(2) << std::setw(10) << buildMs << "\n";
+}
+
+int main(int argc, char* argv[])
+{
+    // 1. string of main.cpp
+    const std::string str {"Hello Guys the online meeting starts now"};
+    std::cout << startFromWord(str, "the online meeting starts now") << "\n";
+    const std::vector<std::string_view> words{"the", "meeting", "now", "online meeting", "e"};
+    const text::MultiMatcher matcher{words};
+    for (const auto& [offset, pattern] : matcher.findAll(str)) std::cout << words[pattern] << " at " << offset << ", ";
+    std::cout << "\n\n";
+
+    // 2. text of random words
+    const size_t size = (argc > 1 ? std::stoul(argv[1]) : 64) * 1'000'000;
+    std::mt19937 gen{42};
+    std::uniform_int_distribution<int> letter{'a', 'z'};
+    std::uniform_int_distribution<size_t> length{3, 10};
+    std::vector<std::string> vocabulary(5000);
+    for (auto& word : vocabulary) {
+        word.resize(length(gen));
+        for (auto& c : word) c = static_cast<char>(letter(gen));
+    }
+    std::uniform_int_distribution<size_t> pickWord{0, vocabulary.size() - 1};
+    std::string log;
+    log.reserve(size + 16);
+    for (size_t words = 1; log.size() < size; ++words) {
+        log += vocabulary[pickWord(gen)];
+        log += words % 12 == 0 ? '\n' : ' ';
+    }
+    const std::string_view text = log;
+
+    std::cout << "one needle, MB/s                            boyer_moore\n";
+    std::cout << " needle  matches  std::search  boyer_moore  horspool  string_view::find  text::Finder\n";
+    std::uniform_int_distribution<size_t> pickOffset{0, text.size() - 64};
+    for (size_t needleSize : {4, 8, 16, 32}) benchmarkNeedle(text, text.substr(pickOffset(gen), needleSize));
+
+    std::cout << "\npatterns, MB/s\n";
+    std::cout << " patterns   matches  Finder each  MultiMatcher   states  build ms\n";
+    for (size_t count : {10, 100, 500}) {
+        std::vector<std::string> patterns(count);
+        for (auto& pattern : patterns) pattern = vocabulary[pickWord(gen)] + ' ';
+        benchmarkPatterns(text, patterns);
+    }
+}
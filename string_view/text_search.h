@@ -0,0 +1,334 @@
+/*
+
+Searching a string_view for one needle or for hundreds of patterns at once, every match offset is returned.
+
+text::Finder: one needle, the first / last byte filter. The first byte of the needle is compared with 32 positions
+of the text at once (AVX2, 16 with SSE2: chosen at runtime with __builtin_cpu_supports), the last byte with the 32 positions needle size - 1 further: only the
+positions where both match are compared with memcmp. On a text where the 2 bytes are rare together, the text is
+read at the speed of 2 vector compares per 32 bytes.
+
+    const text::Finder finder{"Super"};
+    for (size_t offset : finder.findAll(text)) std::cout << offset << " ";
+    std::string_view rest = text.substr(std::min(finder.find(text), text.size()));
+
+text::MultiMatcher: Aho-Corasick automaton on all the patterns, compiled into a full DFA. The bytes which appear in
+no pattern share one class, each state is a row of one uint32_t per class: one table lookup per byte of the text,
+whatever the number of patterns. The next row is stored premultiplied, with the high bit set when the state ends
+a pattern (the matches are only looked up then). findAll and count walk 4 parts of the text interleaved: the table
+lookups of one walk do not wait for the previous lookup of the others.
+
+    const text::MultiMatcher matcher{std::vector<std::string_view>{"error", "timeout", "refused"}};
+    for (const auto& [offset, pattern] : matcher.findAll(log)) std::cout << pattern << " at " << offset << "\n";
+
+Both report all the matches, overlapping ones included. An empty needle or pattern throws std::invalid_argument.
+The AVX2 filter is compiled with target("avx2") and only runs on a CPU which has it, no -mavx2 needed.
+
+C++17
+
+*/
+
+#ifndef TEXT_SEARCH_H
+#define TEXT_SEARCH_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TEXT_SEARCH_X86
+#define TEXT_SEARCH_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace text {
+
+constexpr size_t npos = std::string_view::npos;
+
+namespace detail {
+
+#if defined(TEXT_SEARCH_X86)
+inline bool hasAvx2()
+{
+    static const bool avx2 = __builtin_cpu_supports("avx2");   // checked once
+    return avx2;
+}
+#endif
+
+} // namespace detail
+
+
+// 1. One needle: first / last byte filter
+
+class Finder {
+ public:
+    explicit Finder(std::string_view needle):m_needle{needle} {
+        if (m_needle.empty()) throw std::invalid_argument{"text::Finder: empty needle"};
+    }
+
+    // offset of the first match at or after from, npos if none
+    size_t find(std::string_view text, size_t from = 0) const {
+        const size_t size = m_needle.size();
+        if (from > text.size() || text.size() - from < size) return npos;
+        const char* const data = text.data();
+        const size_t lastStart = text.size() - size;
+        if (size == 1) {
+            const void* found = std::memchr(data + from, m_needle[0], text.size() - from);
+            return found ? static_cast<const char*>(found) - data : npos;
+        }
+        size_t start = from;
+#if defined(TEXT_SEARCH_X86)
+        if (detail::hasAvx2()) {
+            if (size_t found = scanAvx2(data, start, lastStart); found != npos) return found;
+        }
+#endif
+#if defined(__SSE2__)
+        if (size_t found = scanSse2(data, start, lastStart); found != npos) return found;
+#endif
+        // the last positions, less than one vector
+        for (; start <= lastStart; ++start) {
+            if (data[start] == m_needle.front() && data[start + size - 1] == m_needle.back() &&
+                std::memcmp(data + start + 1, m_needle.data() + 1, size - 2) == 0) return start;
+        }
+        return npos;
+    }
+
+    std::vector<size_t> findAll(std::string_view text) const {
+        std::vector<size_t> offsets;
+        for (size_t offset = find(text); offset != npos; offset = find(text, offset + 1)) offsets.push_back(offset);
+        return offsets;
+    }
+
+    std::string_view needle() const { return m_needle; }
+
+ private:
+    // the vector scans: first match of the whole blocks from start, npos if none. start is left on the first
+    // position not scanned, the SSE2 scan then the loop of find() go on from there
+#if defined(TEXT_SEARCH_X86)
+    TEXT_SEARCH_AVX2 size_t scanAvx2(const char* data, size_t& start, size_t lastStart) const {
+        const size_t size = m_needle.size();
+        const __m256i first = _mm256_set1_epi8(m_needle.front());
+        const __m256i last = _mm256_set1_epi8(m_needle.back());
+        for (; start + 32 <= lastStart + 1; start += 32) {
+            const __m256i blockFirst = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + start));
+            const __m256i blockLast = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + start + size - 1));
+            uint32_t candidates = static_cast<uint32_t>(_mm256_movemask_epi8(
+                _mm256_and_si256(_mm256_cmpeq_epi8(first, blockFirst), _mm256_cmpeq_epi8(last, blockLast))));
+            if (size_t found = firstCandidate(data + start, candidates); found != npos) return start + found;
+        }
+        return npos;
+    }
+#endif
+
+#if defined(__SSE2__)
+    size_t scanSse2(const char* data, size_t& start, size_t lastStart) const {
+        const size_t size = m_needle.size();
+        const __m128i first = _mm_set1_epi8(m_needle.front());
+        const __m128i last = _mm_set1_epi8(m_needle.back());
+        for (; start + 16 <= lastStart + 1; start += 16) {
+            const __m128i blockFirst = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + start));
+            const __m128i blockLast = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + start + size - 1));
+            uint32_t candidates = static_cast<uint32_t>(_mm_movemask_epi8(
+                _mm_and_si128(_mm_cmpeq_epi8(first, blockFirst), _mm_cmpeq_epi8(last, blockLast))));
+            if (size_t found = firstCandidate(data + start, candidates); found != npos) return start + found;
+        }
+        return npos;
+    }
+#endif
+
+    // candidates: bit i set if position i of block starts with the first and ends with the last byte
+    size_t firstCandidate(const char* block, uint32_t candidates) const {
+        for (; candidates != 0; candidates &= candidates - 1) {
+            const unsigned bit = static_cast<unsigned>(__builtin_ctz(candidates));
+            if (std::memcmp(block + bit + 1, m_needle.data() + 1, m_needle.size() - 2) == 0) return bit;
+        }
+        return npos;
+    }
+
+    std::string m_needle;
+};
+
+
+// 2. Pattern set: Aho-Corasick DFA
+
+class MultiMatcher {
+ public:
+    struct Match {
+        size_t offset;          // of the first byte of the match in the text
+        uint32_t pattern;       // index of the pattern
+    };
+
+    template<typename Patterns>
+    explicit MultiMatcher(const Patterns& patterns) {
+        for (std::string_view pattern : patterns) {
+            if (pattern.empty()) throw std::invalid_argument{"text::MultiMatcher: empty pattern"};
+            m_lengths.push_back(static_cast<uint32_t>(pattern.size()));
+            m_maxLength = std::max(m_maxLength, pattern.size());
+        }
+        build(std::vector<std::string_view>(std::begin(patterns), std::end(patterns)));
+    }
+
+    // f(Match) for each match, in the order of the end of the matches
+    template<typename F>
+    void forEach(std::string_view text, F&& f) const {
+        uint32_t row = 0;
+        for (size_t i = 0; i < text.size(); ++i) {
+            const uint32_t cell = step(row, text[i]);
+            row = cell & ~kMatchBit;
+            if (cell & kMatchBit) report(row, i, f);
+        }
+    }
+
+    // same matches and order as forEach, with the walks of kStreams parts of the text interleaved
+    std::vector<Match> findAll(std::string_view text) const {
+        std::vector<Match> streams[kStreams];
+        scanStreams(text, [&streams](size_t stream, const Match& match) { streams[stream].push_back(match); });
+        for (size_t stream = 1; stream < kStreams; ++stream) {
+            streams[0].insert(streams[0].end(), streams[stream].begin(), streams[stream].end());
+        }
+        return std::move(streams[0]);
+    }
+
+    size_t count(std::string_view text) const {
+        size_t count = 0;
+        scanStreams(text, [&count](size_t, const Match&) { ++count; });
+        return count;
+    }
+
+    size_t patterns() const { return m_lengths.size(); }
+    size_t states() const { return m_outputStart.size() - 1; }
+
+ private:
+    static constexpr uint32_t kMatchBit = 1u << 31;
+    static constexpr size_t kStreams = 4;
+
+    uint32_t step(uint32_t row, char c) const { return m_next[row + m_classes[static_cast<unsigned char>(c)]]; }
+
+    // f(Match) for the patterns ending at byte end, row: the state reached there
+    template<typename F>
+    void report(uint32_t row, size_t end, F&& f) const {
+        const uint32_t state = row / m_stride;
+        for (uint32_t output = m_outputStart[state]; output < m_outputStart[state + 1]; ++output) {
+            const uint32_t pattern = m_outputs[output];
+            f(Match{end + 1 - m_lengths[pattern], pattern});
+        }
+    }
+
+    // One walk of the DFA waits for each lookup before the next one: the walks of kStreams consecutive parts of the
+    // text run interleaved instead. The state only depends on the last m_maxLength bytes, so each walk starts
+    // m_maxLength bytes before its part and reports the matches ending in its part. f(stream, Match)
+    template<typename F>
+    void scanStreams(std::string_view text, F&& f) const {
+        const size_t part = text.size() / kStreams;
+        if (part <= m_maxLength) {
+            forEach(text, [&f](const Match& match) { f(0, match); });
+            return;
+        }
+        uint32_t rows[kStreams] = {};
+        for (size_t stream = 1; stream < kStreams; ++stream) {
+            for (size_t i = stream * part - m_maxLength; i < stream * part; ++i) rows[stream] = step(rows[stream], text[i]) & ~kMatchBit;
+        }
+        for (size_t i = 0; i < part; ++i) {
+            for (size_t stream = 0; stream < kStreams; ++stream) {
+                const size_t end = stream * part + i;
+                const uint32_t cell = step(rows[stream], text[end]);
+                rows[stream] = cell & ~kMatchBit;
+                if (cell & kMatchBit) report(rows[stream], end, [&f, stream](const Match& match) { f(stream, match); });
+            }
+        }
+        // the last walk goes on to the end of the text
+        uint32_t& row = rows[kStreams - 1];
+        for (size_t end = kStreams * part; end < text.size(); ++end) {
+            const uint32_t cell = step(row, text[end]);
+            row = cell & ~kMatchBit;
+            if (cell & kMatchBit) report(row, end, [&f](const Match& match) { f(kStreams - 1, match); });
+        }
+    }
+
+    void build(const std::vector<std::string_view>& patterns) {
+        // byte classes: 0 for the bytes in no pattern
+        m_classes.fill(0);
+        for (auto pattern : patterns) {
+            for (unsigned char c : pattern) m_classes[c] = 1;
+        }
+        m_stride = 1;
+        for (auto& byteClass : m_classes) {
+            if (byteClass != 0) byteClass = static_cast<uint16_t>(m_stride++);
+        }
+
+        // trie: -1 for no child, state 0 is the root
+        std::vector<std::vector<int32_t>> children(1, std::vector<int32_t>(m_stride, -1));
+        std::vector<std::vector<uint32_t>> outputs(1);
+        for (uint32_t index = 0; index < patterns.size(); ++index) {
+            size_t state = 0;
+            for (unsigned char c : patterns[index]) {
+                int32_t& child = children[state][m_classes[c]];
+                if (child < 0) {
+                    child = static_cast<int32_t>(children.size());
+                    children.emplace_back(m_stride, -1);
+                    outputs.emplace_back();
+                }
+                state = static_cast<size_t>(child);
+            }
+            outputs[state].push_back(index);
+        }
+        if (children.size() * m_stride >= kMatchBit) throw std::length_error{"text::MultiMatcher: too many patterns"};
+
+        // breadth first: the missing transitions take the ones of the failure state, which is closer to the root
+        std::vector<uint32_t> fail(children.size(), 0);
+        std::deque<uint32_t> queue;
+        for (auto& child : children[0]) {
+            if (child < 0) child = 0;
+            else if (child > 0) queue.push_back(static_cast<uint32_t>(child));
+        }
+        while (!queue.empty()) {
+            const uint32_t state = queue.front();
+            queue.pop_front();
+            const auto& inherited = outputs[fail[state]];
+            outputs[state].insert(outputs[state].end(), inherited.begin(), inherited.end());
+            for (size_t c = 0; c < m_stride; ++c) {
+                int32_t& child = children[state][c];
+                const int32_t fallback = children[fail[state]][c];
+                if (child < 0) {
+                    child = fallback;
+                    continue;
+                }
+                fail[static_cast<size_t>(child)] = static_cast<uint32_t>(fallback);
+                queue.push_back(static_cast<uint32_t>(child));
+            }
+        }
+
+        // flat table, next rows premultiplied by the stride
+        m_next.resize(children.size() * m_stride);
+        m_outputStart.assign(1, 0);
+        for (size_t state = 0; state < children.size(); ++state) {
+            for (size_t c = 0; c < m_stride; ++c) {
+                const auto child = static_cast<uint32_t>(children[state][c]);
+                m_next[state * m_stride + c] = static_cast<uint32_t>(child * m_stride) | (outputs[child].empty() ? 0 : kMatchBit);
+            }
+            m_outputs.insert(m_outputs.end(), outputs[state].begin(), outputs[state].end());
+            m_outputStart.push_back(static_cast<uint32_t>(m_outputs.size()));
+        }
+    }
+
+    std::array<uint16_t, 256> m_classes;
+    uint32_t m_stride = 1;                  // classes per state
+    std::vector<uint32_t> m_next;           // state * m_stride + class -> next state * m_stride | kMatchBit
+    std::vector<uint32_t> m_outputStart;    // patterns ending at state s: m_outputs[m_outputStart[s], m_outputStart[s + 1])
+    std::vector<uint32_t> m_outputs;
+    std::vector<uint32_t> m_lengths;        // of each pattern
+    size_t m_maxLength = 0;
+};
+
+} // namespace text
+
+#undef TEXT_SEARCH_AVX2
+#undef TEXT_SEARCH_X86
+
+#endif // TEXT_SEARCH_H